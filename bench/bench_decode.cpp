@@ -0,0 +1,354 @@
+/*
+bench_decode - decoder cost over a generated corpus (see navic_corpus.h):
+encode() throughput a byte at a time and in blocks, the cost of custom
+term subscribers, navic_parser<Fields>, navic_uart_ring, sentence dedup,
+the public term parsers and the scalar geodesy
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include <benchmark/benchmark.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "navic_corpus.h"
+#include "navic_dedup.h"
+#include "navic_parser.h"
+#include "navic_ring.h"
+#include "navic_rmc_gga++.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES() __rdtsc()
+#else
+#define CYCLES() 0
+#endif
+
+namespace
+{
+// About 1 MB: larger than L2 on most hosts, as a long log would be
+const size_t EPOCHS = 1500;
+
+const std::string &corpus()
+{
+  static std::string text = navic_corpus(1).generate(EPOCHS);
+  return text;
+}
+
+// Every sentence twice in a row, as from a receiver on two links
+const std::string &doubledCorpus()
+{
+  static std::string text;
+  if (text.empty())
+  {
+    const std::string &single = corpus();
+    for (size_t start = 0, next; start < single.size(); start = next)
+    {
+      next = single.find('$', start + 1);
+      if (next == std::string::npos)
+        next = single.size();
+      text.append(single, start, next - start);
+      text.append(single, start, next - start);
+    }
+  }
+  return text;
+}
+
+// Terms of the corpus's RMC and GGA sentences, each in a padded buffer
+struct Term
+{
+  char text[_NavIC_MAX_FIELD_SIZE + 8];
+};
+
+struct Terms
+{
+  std::vector<Term> decimals, degrees;
+  std::vector<double> lat, lng;
+
+  Terms()
+  {
+    const std::string &text = corpus();
+    for (size_t start = text.find('$'); start != std::string::npos; start = text.find('$', start + 1))
+    {
+      size_t end = text.find_first_of("*$", start + 1);
+      std::string line = text.substr(start + 1, end == std::string::npos ? std::string::npos : end - start - 1);
+      bool rmc = line.compare(0, 6, "GNRMC,") == 0, gga = line.compare(0, 6, "GNGGA,") == 0;
+      if (!rmc && !gga)
+        continue;
+
+      std::vector<std::string> fields;
+      for (size_t p = 0, q; p != std::string::npos; p = q == std::string::npos ? q : q + 1)
+      {
+        q = line.find(',', p);
+        fields.push_back(line.substr(p, q == std::string::npos ? q : q - p));
+      }
+      // RMC time, lat, lng, speed, course; GGA time, lat, lng, hdop, altitude
+      static const unsigned rmcDecimals[] = {1, 7, 8}, ggaDecimals[] = {1, 8, 9};
+      const unsigned *decimalTerms = rmc ? rmcDecimals : ggaDecimals;
+      unsigned latTerm = rmc ? 3 : 2;
+      if (fields.size() < 10)
+        continue;
+      for (unsigned i = 0; i < 3; ++i)
+        add(decimals, fields[decimalTerms[i]]);
+      add(degrees, fields[latTerm]);
+      add(degrees, fields[latTerm + 2]);
+      if (rmc)
+      {
+        RawDegrees a, b;
+        navic_gn_rmc_gga::parseDegrees(fields[3].c_str(), a);
+        navic_gn_rmc_gga::parseDegrees(fields[5].c_str(), b);
+        lat.push_back(a.deg + a.billionths / 1e9);
+        lng.push_back(b.deg + b.billionths / 1e9);
+      }
+    }
+  }
+
+  static void add(std::vector<Term> &to, const std::string &text)
+  {
+    Term t;
+    memset(t.text, 0, sizeof(t.text));
+    strncpy(t.text, text.c_str(), _NavIC_MAX_FIELD_SIZE - 1);
+    to.push_back(t);
+  }
+};
+
+const Terms &terms()
+{
+  static Terms t;
+  return t;
+}
+
+// Subscribers spread over the corpus's sentences and terms as an
+// application would use them, plus names that never occur
+const char *const customNames[] = {"GNRMC", "GNGGA", "GNVTG", "GNGSA", "GPGSV", "GIGSV", "GNZDA", "PUBX"};
+
+void subscribe(navic_gn_rmc_gga &navic, std::vector<NavIC_CUSTOM> &customs)
+{
+  for (size_t i = 0; i < customs.size(); ++i)
+  {
+    size_t names = sizeof(customNames) / sizeof(customNames[0]);
+    customs[i].begin(navic, customNames[i % names], 1 + (int)(i / names + i) % 12);
+  }
+}
+
+void encodeBytes(navic_gn_rmc_gga &navic, const std::string &text)
+{
+  for (size_t i = 0; i < text.size(); ++i)
+    navic.encode(text[i]);
+}
+
+void encodeBlocks(navic_gn_rmc_gga &navic, const std::string &text, size_t block)
+{
+  for (size_t i = 0; i < text.size(); i += block)
+    navic.encode(text.data() + i, text.size() - i < block ? text.size() - i : block);
+}
+
+void report(benchmark::State &state, const navic_gn_rmc_gga &navic, uint64_t cycles)
+{
+  const std::string &text = corpus();
+  state.SetBytesProcessed(state.iterations() * text.size());
+  state.counters["cycles_per_byte"] = (double)cycles / (state.iterations() * text.size());
+  state.counters["sentences"] = benchmark::Counter((double)navic.passedChecksum() + navic.failedChecksum(), benchmark::Counter::kIsRate);
+  state.counters["failed"] = (double)navic.failedChecksum() / state.iterations();
+}
+}
+
+static void BM_EncodeByte(benchmark::State &state)
+{
+  const std::string &text = corpus();
+  navic_gn_rmc_gga navic;
+  uint64_t cycles = 0;
+  for (auto _ : state)
+  {
+    uint64_t start = CYCLES();
+    encodeBytes(navic, text);
+    cycles += CYCLES() - start;
+  }
+  report(state, navic, cycles);
+}
+BENCHMARK(BM_EncodeByte);
+
+// Argument: block size, as read() or a DMA buffer would hand it over
+static void BM_EncodeBulk(benchmark::State &state)
+{
+  const std::string &text = corpus();
+  navic_gn_rmc_gga navic;
+  uint64_t cycles = 0;
+  for (auto _ : state)
+  {
+    uint64_t start = CYCLES();
+    encodeBlocks(navic, text, state.range(0));
+    cycles += CYCLES() - start;
+  }
+  report(state, navic, cycles);
+}
+BENCHMARK(BM_EncodeBulk)->Arg(16)->Arg(256)->Arg(4096);
+
+// Arguments: custom subscribers, then 0 for encode(char) or a block size
+static void BM_EncodeCustoms(benchmark::State &state)
+{
+  const std::string &text = corpus();
+  navic_gn_rmc_gga navic;
+  std::vector<NavIC_CUSTOM> customs(state.range(0));
+  subscribe(navic, customs);
+  uint64_t cycles = 0;
+  for (auto _ : state)
+  {
+    uint64_t start = CYCLES();
+    if (state.range(1))
+      encodeBlocks(navic, text, state.range(1));
+    else
+      encodeBytes(navic, text);
+    cycles += CYCLES() - start;
+  }
+  report(state, navic, cycles);
+}
+BENCHMARK(BM_EncodeCustoms)->Args({0, 0})->Args({10, 0})->Args({100, 0})->Args({0, 256})->Args({10, 256})->Args({100, 256});
+
+// navic_parser<Fields> over the same corpus in 256-byte blocks
+template <uint8_t Fields>
+static void BM_Parser(benchmark::State &state)
+{
+  const std::string &text = corpus();
+  navic_parser<Fields> navic;
+  uint64_t cycles = 0;
+  for (auto _ : state)
+  {
+    uint64_t start = CYCLES();
+    for (size_t i = 0; i < text.size(); i += 256)
+      navic.encode(text.data() + i, text.size() - i < 256 ? text.size() - i : 256);
+    cycles += CYCLES() - start;
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+  state.counters["cycles_per_byte"] = (double)cycles / (state.iterations() * text.size());
+  state.counters["bytes_of_state"] = sizeof(navic);
+}
+BENCHMARK_TEMPLATE(BM_Parser, 0xFF);
+BENCHMARK_TEMPLATE(BM_Parser, NavIC_fix::TIME | NavIC_fix::LOCATION);
+BENCHMARK_TEMPLATE(BM_Parser, NavIC_fix::TIME);
+
+// Argument: 1 to attach a navic_sentence_cache.  The doubled corpus in
+// 4096-byte blocks, as a dual-homed gateway would read it.
+static void BM_EncodeDedup(benchmark::State &state)
+{
+  const std::string &text = doubledCorpus();
+  navic_gn_rmc_gga navic;
+  navic_sentence_cache cache;
+  if (state.range(0))
+    navic.dedup(&cache);
+  uint64_t cycles = 0;
+  for (auto _ : state)
+  {
+    uint64_t start = CYCLES();
+    encodeBlocks(navic, text, 4096);
+    cycles += CYCLES() - start;
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+  state.counters["cycles_per_byte"] = (double)cycles / (state.iterations() * text.size());
+  state.counters["suppressed"] = (double)cache.suppressed() / state.iterations();
+  state.counters["passed"] = (double)navic.passedChecksum() / state.iterations();
+}
+BENCHMARK(BM_EncodeDedup)->Arg(0)->Arg(1);
+
+// Argument: bytes put() between drain()s, as the main loop would lag the
+// receive interrupt
+static void BM_RingDrain(benchmark::State &state)
+{
+  const std::string &text = corpus();
+  static navic_uart_ring<4096> ring;
+  navic_gn_rmc_gga navic;
+  size_t interval = state.range(0);
+  uint64_t cycles = 0, putCycles = 0;
+  for (auto _ : state)
+  {
+    uint64_t start = CYCLES();
+    for (size_t i = 0; i < text.size(); i += interval)
+    {
+      uint64_t put = CYCLES();
+      ring.put(text.data() + i, text.size() - i < interval ? text.size() - i : interval);
+      putCycles += CYCLES() - put;
+      ring.drain(navic);
+    }
+    cycles += CYCLES() - start;
+  }
+  report(state, navic, cycles);
+  state.counters["put_cycles_per_byte"] = (double)putCycles / (state.iterations() * text.size());
+  state.counters["dropped"] = ring.dropped();
+}
+BENCHMARK(BM_RingDrain)->Arg(64)->Arg(1024);
+
+static void BM_ParseDecimal(benchmark::State &state)
+{
+  const std::vector<Term> &input = terms().decimals;
+  uint64_t cycles = 0;
+  for (auto _ : state)
+  {
+    uint64_t start = CYCLES();
+    for (size_t i = 0; i < input.size(); ++i)
+      benchmark::DoNotOptimize(navic_gn_rmc_gga::parseDecimal(input[i].text));
+    cycles += CYCLES() - start;
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+  state.counters["cycles_per_term"] = (double)cycles / (state.iterations() * input.size());
+}
+BENCHMARK(BM_ParseDecimal);
+
+static void BM_ParseDegrees(benchmark::State &state)
+{
+  const std::vector<Term> &input = terms().degrees;
+  uint64_t cycles = 0;
+  for (auto _ : state)
+  {
+    uint64_t start = CYCLES();
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+      RawDegrees deg;
+      navic_gn_rmc_gga::parseDegrees(input[i].text, deg);
+      benchmark::DoNotOptimize(deg);
+    }
+    cycles += CYCLES() - start;
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+  state.counters["cycles_per_term"] = (double)cycles / (state.iterations() * input.size());
+}
+BENCHMARK(BM_ParseDegrees);
+
+// Successive RMC fixes of the corpus, as a tracker would measure them
+static void BM_DistanceBetween(benchmark::State &state)
+{
+  const Terms &t = terms();
+  for (auto _ : state)
+  {
+    double total = 0;
+    for (size_t i = 0; i + 1 < t.lat.size(); ++i)
+      total += navic_gn_rmc_gga::distanceBetween(t.lat[i], t.lng[i], t.lat[i + 1], t.lng[i + 1]);
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * (t.lat.size() - 1));
+}
+BENCHMARK(BM_DistanceBetween);
+
+static void BM_CourseTo(benchmark::State &state)
+{
+  const Terms &t = terms();
+  for (auto _ : state)
+  {
+    double total = 0;
+    for (size_t i = 0; i + 1 < t.lat.size(); ++i)
+      total += navic_gn_rmc_gga::courseTo(t.lat[i], t.lng[i], t.lat[i + 1], t.lng[i + 1]);
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * (t.lat.size() - 1));
+}
+BENCHMARK(BM_CourseTo);
+
+BENCHMARK_MAIN();
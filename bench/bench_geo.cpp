@@ -0,0 +1,260 @@
+/*
+bench_geo - throughput and accuracy of the batch geodesy against the scalar
+distanceBetween()/courseTo(), and geofence lookups through navic_fence_index
+against a scan of every fence
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include <benchmark/benchmark.h>
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "navic_fence.h"
+#include "navic_geo.h"
+
+namespace
+{
+// Pairs spread over the globe and a track of 1 s fixes at walking to
+// driving speeds, both from a fixed seed
+struct Points
+{
+  std::vector<double> lat1, lng1, lat2, lng2;
+  std::vector<double> trackLat, trackLng;
+
+  explicit Points(size_t n) : lat1(n), lng1(n), lat2(n), lng2(n), trackLat(n), trackLng(n)
+  {
+    srand(1);
+    double lat = 12.97, lng = 77.59;
+    for (size_t i = 0; i < n; ++i)
+    {
+      lat1[i] = rand() * 180.0 / RAND_MAX - 90;
+      lng1[i] = rand() * 360.0 / RAND_MAX - 180;
+      lat2[i] = rand() * 180.0 / RAND_MAX - 90;
+      lng2[i] = rand() * 360.0 / RAND_MAX - 180;
+      lat += (rand() * 2.0 / RAND_MAX - 1) * 3e-4;
+      lng += (rand() * 2.0 / RAND_MAX - 1) * 3e-4;
+      trackLat[i] = lat;
+      trackLng[i] = lng;
+    }
+  }
+};
+
+const size_t N = 1 << 16;
+
+const Points &points()
+{
+  static Points p(N);
+  return p;
+}
+
+double maxError(const std::vector<double> &a, const std::vector<double> &b)
+{
+  double worst = 0;
+  for (size_t i = 0; i < a.size(); ++i)
+    worst = fmax(worst, fabs(a[i] - b[i]));
+  return worst;
+}
+
+// Circles of 50 m to 2 km around the track's start, as depots, stops and
+// no-go zones of a city would be
+struct Fences
+{
+  std::vector<double> lat, lng, radius;
+  navic_fence_index index;
+
+  explicit Fences(size_t n) : lat(n), lng(n), radius(n)
+  {
+    srand(2);
+    for (size_t i = 0; i < n; ++i)
+    {
+      lat[i] = 12.97 + (rand() * 2.0 / RAND_MAX - 1) * 0.1;
+      lng[i] = 77.59 + (rand() * 2.0 / RAND_MAX - 1) * 0.1;
+      radius[i] = 50 + rand() % 1950;
+      index.add(i, (int32_t)lround(lat[i] * 1e7), (int32_t)lround(lng[i] * 1e7), radius[i]);
+    }
+    index.build();
+  }
+};
+
+const Fences &fences(size_t n)
+{
+  static Fences small(1000), large(10000);
+  return n == 1000 ? small : large;
+}
+
+const size_t FENCE_POINTS = 4096;
+
+std::vector<int32_t> e7(const std::vector<double> &degrees)
+{
+  std::vector<int32_t> out(FENCE_POINTS);
+  for (size_t i = 0; i < FENCE_POINTS; ++i)
+    out[i] = (int32_t)lround(degrees[i] * 1e7);
+  return out;
+}
+}
+
+static void BM_DistanceScalar(benchmark::State &state)
+{
+  const Points &p = points();
+  std::vector<double> out(N);
+  for (auto _ : state)
+  {
+    for (size_t i = 0; i < N; ++i)
+      out[i] = navic_gn_rmc_gga::distanceBetween(p.lat1[i], p.lng1[i], p.lat2[i], p.lng2[i]);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * N);
+}
+BENCHMARK(BM_DistanceScalar);
+
+static void BM_DistanceBatch(benchmark::State &state)
+{
+  const Points &p = points();
+  NavIC_geo_accuracy accuracy = (NavIC_geo_accuracy)state.range(0);
+  std::vector<double> out(N), ref(N);
+  for (auto _ : state)
+  {
+    navic_distance_batch(p.lat1.data(), p.lng1.data(), p.lat2.data(), p.lng2.data(), out.data(), N, accuracy);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * N);
+
+  for (size_t i = 0; i < N; ++i)
+    ref[i] = navic_gn_rmc_gga::distanceBetween(p.lat1[i], p.lng1[i], p.lat2[i], p.lng2[i]);
+  state.counters["max_err_m"] = maxError(out, ref);
+}
+BENCHMARK(BM_DistanceBatch)->Arg(NAVIC_GEO_FAST)->Arg(NAVIC_GEO_PRECISE);
+
+static void BM_CourseScalar(benchmark::State &state)
+{
+  const Points &p = points();
+  std::vector<double> out(N);
+  for (auto _ : state)
+  {
+    for (size_t i = 0; i < N; ++i)
+      out[i] = navic_gn_rmc_gga::courseTo(p.lat1[i], p.lng1[i], p.lat2[i], p.lng2[i]);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * N);
+}
+BENCHMARK(BM_CourseScalar);
+
+static void BM_CourseBatch(benchmark::State &state)
+{
+  const Points &p = points();
+  NavIC_geo_accuracy accuracy = (NavIC_geo_accuracy)state.range(0);
+  std::vector<double> out(N), ref(N);
+  for (auto _ : state)
+  {
+    navic_course_batch(p.lat1.data(), p.lng1.data(), p.lat2.data(), p.lng2.data(), out.data(), N, accuracy);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * N);
+
+  // compare on the circle so 359.999 against 0.001 is not a large error
+  for (size_t i = 0; i < N; ++i)
+  {
+    double d = fabs(out[i] - navic_gn_rmc_gga::courseTo(p.lat1[i], p.lng1[i], p.lat2[i], p.lng2[i]));
+    out[i] = fmin(d, 360 - d);
+    ref[i] = 0;
+  }
+  state.counters["max_err_deg"] = maxError(out, ref);
+}
+BENCHMARK(BM_CourseBatch)->Arg(NAVIC_GEO_FAST)->Arg(NAVIC_GEO_PRECISE);
+
+static void BM_TrackScalar(benchmark::State &state)
+{
+  const Points &p = points();
+  for (auto _ : state)
+  {
+    double total = 0;
+    for (size_t i = 0; i + 1 < N; ++i)
+      total += navic_gn_rmc_gga::distanceBetween(p.trackLat[i], p.trackLng[i], p.trackLat[i + 1], p.trackLng[i + 1]);
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * (N - 1));
+}
+BENCHMARK(BM_TrackScalar);
+
+static void BM_TrackSegments(benchmark::State &state)
+{
+  const Points &p = points();
+  NavIC_geo_accuracy accuracy = (NavIC_geo_accuracy)state.range(0);
+  std::vector<double> out(N - 1), ref(N - 1);
+  for (auto _ : state)
+  {
+    navic_track_segments(p.trackLat.data(), p.trackLng.data(), N, out.data(), accuracy);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * (N - 1));
+
+  for (size_t i = 0; i + 1 < N; ++i)
+    ref[i] = navic_gn_rmc_gga::distanceBetween(p.trackLat[i], p.trackLng[i], p.trackLat[i + 1], p.trackLng[i + 1]);
+  state.counters["max_err_m"] = maxError(out, ref);
+}
+BENCHMARK(BM_TrackSegments)->Arg(NAVIC_GEO_FAST)->Arg(NAVIC_GEO_PRECISE);
+
+// Argument: number of fences.  Items are track fixes tested against all
+// of them.
+static void BM_FenceScan(benchmark::State &state)
+{
+  const Points &p = points();
+  const Fences &f = fences(state.range(0));
+  size_t hits = 0;
+  for (auto _ : state)
+  {
+    hits = 0;
+    for (size_t i = 0; i < FENCE_POINTS; ++i)
+      for (size_t j = 0; j < f.lat.size(); ++j)
+        hits += navic_gn_rmc_gga::distanceBetween(p.trackLat[i], p.trackLng[i], f.lat[j], f.lng[j]) <= f.radius[j];
+    benchmark::DoNotOptimize(hits);
+  }
+  state.SetItemsProcessed(state.iterations() * FENCE_POINTS);
+  state.counters["hits_per_fix"] = (double)hits / FENCE_POINTS;
+}
+BENCHMARK(BM_FenceScan)->Arg(1000)->Arg(10000);
+
+static void BM_FenceIndex(benchmark::State &state)
+{
+  const Points &p = points();
+  const Fences &f = fences(state.range(0));
+  std::vector<int32_t> lat = e7(p.trackLat), lng = e7(p.trackLng);
+  std::vector<uint32_t> ids;
+  for (auto _ : state)
+  {
+    ids.clear();
+    for (size_t i = 0; i < FENCE_POINTS; ++i)
+      f.index.query(lat[i], lng[i], ids);
+    benchmark::DoNotOptimize(ids.data());
+  }
+  state.SetItemsProcessed(state.iterations() * FENCE_POINTS);
+  state.counters["hits_per_fix"] = (double)ids.size() / FENCE_POINTS;
+}
+BENCHMARK(BM_FenceIndex)->Arg(1000)->Arg(10000);
+
+static void BM_FenceBatch(benchmark::State &state)
+{
+  const Points &p = points();
+  const Fences &f = fences(state.range(0));
+  std::vector<int32_t> lat = e7(p.trackLat), lng = e7(p.trackLng);
+  std::vector<uint32_t> ids, offsets;
+  for (auto _ : state)
+  {
+    f.index.query(lat.data(), lng.data(), FENCE_POINTS, ids, offsets);
+    benchmark::DoNotOptimize(ids.data());
+  }
+  state.SetItemsProcessed(state.iterations() * FENCE_POINTS);
+  state.counters["hits_per_fix"] = (double)ids.size() / FENCE_POINTS;
+}
+BENCHMARK(BM_FenceBatch)->Arg(1000)->Arg(10000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,165 @@
+/*
+bench_parse - per-term cost of the numeric field parsers against the atol
+and isdigit based originals
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include <benchmark/benchmark.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "navic_digits.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES() __rdtsc()
+#else
+#define CYCLES() 0
+#endif
+
+namespace
+{
+// Terms as they appear in RMC/GGA, each in a padded buffer like the
+// parser's own term
+struct Term
+{
+  char text[_NavIC_MAX_FIELD_SIZE + 8];
+};
+
+const char *const decimals[] = {"123519.00", "022.4", "084.4", "545.4", "0.9", "1.25", "-12.75", "10.123"};
+const char *const degrees[] = {"4807.038", "01131.000", "1234.56789", "07734.1234567", "0000.0001"};
+const char *const integers[] = {"230394", "08", "12", "311299"};
+
+// A shuffled run of the sample terms, long enough that branch predictors
+// cannot learn the digit counts
+template <size_t N>
+std::vector<Term> terms(const char *const (&texts)[N])
+{
+  std::vector<Term> out(4096);
+  srand(1);
+  for (size_t i = 0; i < out.size(); ++i)
+  {
+    memset(out[i].text, 0, sizeof(out[i].text));
+    strcpy(out[i].text, texts[rand() % N]);
+  }
+  return out;
+}
+
+// The parsers as they were, for comparison
+int32_t libcDecimal(const char *term)
+{
+  bool negative = *term == '-';
+  if (negative)
+    ++term;
+  int32_t ret = 100 * (int32_t)atol(term);
+  while (isdigit(*term))
+    ++term;
+  if (*term == '.' && isdigit(term[1]))
+  {
+    ret += 10 * (term[1] - '0');
+    if (isdigit(term[2]))
+      ret += term[2] - '0';
+  }
+  return negative ? -ret : ret;
+}
+
+void libcDegrees(const char *term, RawDegrees &deg)
+{
+  uint32_t leftOfDecimal = (uint32_t)atol(term);
+  uint16_t minutes = (uint16_t)(leftOfDecimal % 100);
+  uint32_t multiplier = 10000000UL;
+  uint32_t tenMillionthsOfMinutes = minutes * multiplier;
+  deg.deg = (int16_t)(leftOfDecimal / 100);
+  while (isdigit(*term))
+    ++term;
+  if (*term == '.')
+    while (isdigit(*++term))
+    {
+      multiplier /= 10;
+      tenMillionthsOfMinutes += (*term - '0') * multiplier;
+    }
+  deg.billionths = (5 * tenMillionthsOfMinutes + 1) / 3;
+  deg.negative = false;
+}
+
+template <class Parse>
+void run(benchmark::State &state, const std::vector<Term> &input, Parse parse)
+{
+  uint64_t cycles = 0;
+  for (auto _ : state)
+  {
+    uint64_t start = CYCLES();
+    for (size_t i = 0; i < input.size(); ++i)
+      benchmark::DoNotOptimize(parse(input[i].text));
+    cycles += CYCLES() - start;
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+  state.counters["cycles_per_term"] = (double)cycles / (state.iterations() * input.size());
+}
+}
+
+static void BM_DecimalLibc(benchmark::State &state)
+{
+  run(state, terms(decimals), libcDecimal);
+}
+BENCHMARK(BM_DecimalLibc);
+
+static void BM_Decimal(benchmark::State &state)
+{
+  run(state, terms(decimals), [](const char *t) { return navic_parse_decimal<false>(t, 2); });
+}
+BENCHMARK(BM_Decimal);
+
+static void BM_DecimalPadded(benchmark::State &state)
+{
+  run(state, terms(decimals), [](const char *t) { return navic_parse_decimal<true>(t, 2); });
+}
+BENCHMARK(BM_DecimalPadded);
+
+static void BM_DegreesLibc(benchmark::State &state)
+{
+  run(state, terms(degrees), [](const char *t) { RawDegrees d; libcDegrees(t, d); return d.billionths; });
+}
+BENCHMARK(BM_DegreesLibc);
+
+static void BM_Degrees(benchmark::State &state)
+{
+  run(state, terms(degrees), [](const char *t) { RawDegrees d; navic_parse_degrees<false>(t, d); return d.billionths; });
+}
+BENCHMARK(BM_Degrees);
+
+static void BM_DegreesPadded(benchmark::State &state)
+{
+  run(state, terms(degrees), [](const char *t) { RawDegrees d; navic_parse_degrees<true>(t, d); return d.billionths; });
+}
+BENCHMARK(BM_DegreesPadded);
+
+static void BM_IntegerLibc(benchmark::State &state)
+{
+  run(state, terms(integers), [](const char *t) { return (uint32_t)atol(t); });
+}
+BENCHMARK(BM_IntegerLibc);
+
+static void BM_Integer(benchmark::State &state)
+{
+  run(state, terms(integers), [](const char *t) { return navic_parse_uint<false>(t); });
+}
+BENCHMARK(BM_Integer);
+
+static void BM_IntegerPadded(benchmark::State &state)
+{
+  run(state, terms(integers), [](const char *t) { return navic_parse_uint<true>(t); });
+}
+BENCHMARK(BM_IntegerPadded);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,172 @@
+/*
+navic_corpus - reproducible NMEA corpus for the benchmarks: one-second
+epochs of RMC, GGA, VTG, GSA and GSV from a moving receiver, with a share
+of corrupted checksums and lines cut short
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+#ifndef __navic_corpus_h
+#define __navic_corpus_h
+
+#include "navic_platform.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+struct NavIC_corpus_mix
+{
+   uint8_t badChecksumPercent;
+   uint8_t truncatedPercent;
+};
+
+static const NavIC_corpus_mix navic_corpus_default_mix = {2, 1};
+
+// xorshift32, so the corpus is the same on every platform and libc
+class navic_corpus_random
+{
+public:
+   explicit navic_corpus_random(uint32_t seed) : state(seed ? seed : 1) {}
+   uint32_t next()
+   {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      return state;
+   }
+   uint32_t below(uint32_t n) { return next() % n; }
+   double uniform(double lo, double hi) { return lo + (hi - lo) * (next() >> 8) / 16777216.0; }
+
+private:
+   uint32_t state;
+};
+
+class navic_corpus
+{
+public:
+   navic_corpus(uint32_t seed = 1, NavIC_corpus_mix mix = navic_corpus_default_mix)
+       : random(seed), mix(mix), seconds(12 * 3600), date(160426), lat(12.9716), lng(77.5946), course(45), speed(12)
+   {
+   }
+
+   // Appends epochs seconds of output to out
+   void generate(std::string &out, size_t epochs)
+   {
+      for (size_t i = 0; i < epochs; ++i)
+         epoch(out);
+   }
+
+   std::string generate(size_t epochs)
+   {
+      std::string out;
+      generate(out, epochs);
+      return out;
+   }
+
+private:
+   void epoch(std::string &out)
+   {
+      ++seconds;
+      course += random.uniform(-5, 5);
+      course += course < 0 ? 360 : course >= 360 ? -360 : 0;
+      speed += random.uniform(-1, 1);
+      speed = speed < 0 ? 0 : speed;
+      // 1 knot is 1/60 minute of arc
+      lat += speed * cos(course * DEG_TO_RAD) / 3600 / 60;
+      lng += speed * sin(course * DEG_TO_RAD) / 3600 / 60;
+
+      bool fix = random.below(100) < 95;
+      uint8_t used = fix ? 6 + random.below(10) : 0;
+      double hdop = fix ? random.uniform(0.6, 3) : 99.99;
+      char time[16], latText[24], lngText[24];
+      snprintf(time, sizeof(time), "%02u%02u%02u.00", (unsigned)(seconds / 3600 % 24), (unsigned)(seconds / 60 % 60), (unsigned)(seconds % 60));
+      coordinate(latText, sizeof(latText), lat, 2, 'N', 'S');
+      coordinate(lngText, sizeof(lngText), lng, 3, 'E', 'W');
+
+      char body[128];
+      snprintf(body, sizeof(body), "GNRMC,%s,%c,%s,%s,%.3f,%.2f,%06u,,,%c", time, fix ? 'A' : 'V', latText, lngText, speed, course,
+               (unsigned)date, fix ? 'A' : 'N');
+      sentence(out, body);
+      snprintf(body, sizeof(body), "GNGGA,%s,%s,%s,%c,%02u,%.2f,%.1f,M,-86.4,M,,", time, latText, lngText, fix ? '1' : '0', (unsigned)used, hdop,
+               random.uniform(900, 930));
+      sentence(out, body);
+      snprintf(body, sizeof(body), "GNVTG,%.2f,T,,M,%.3f,N,%.3f,K,%c", course, speed, speed * 1.852, fix ? 'A' : 'N');
+      sentence(out, body);
+
+      // one GSA per constellation (GPS, then NavIC), then their satellites
+      gsa(out, used / 2, 1, hdop);
+      gsa(out, used - used / 2, 6, hdop);
+      gsv(out, "GP", 9 + random.below(4));
+      gsv(out, "GI", 5 + random.below(3));
+   }
+
+   void gsa(std::string &out, unsigned used, unsigned system, double hdop)
+   {
+      char body[128];
+      int n = snprintf(body, sizeof(body), "GNGSA,A,%c", used ? '3' : '1');
+      for (unsigned i = 0; i < 12; ++i)
+         n += i < used ? snprintf(body + n, sizeof(body) - n, ",%02u", 1 + i * 2) : snprintf(body + n, sizeof(body) - n, ",");
+      snprintf(body + n, sizeof(body) - n, ",%.2f,%.2f,%.2f,%X", hdop * 1.6, hdop, hdop * 1.3, system);
+      sentence(out, body);
+   }
+
+   void gsv(std::string &out, const char *talker, unsigned inView)
+   {
+      unsigned messages = (inView + 3) / 4;
+      for (unsigned m = 0; m < messages; ++m)
+      {
+         char body[128];
+         int n = snprintf(body, sizeof(body), "%sGSV,%u,%u,%02u", talker, messages, m + 1, inView);
+         for (unsigned s = m * 4; s < inView && s < m * 4 + 4; ++s)
+         {
+            // drawn one by one; the order arguments are evaluated in is unspecified
+            unsigned elevation = random.below(90);
+            unsigned azimuth = random.below(360);
+            unsigned snr = random.below(5) ? 20 + random.below(30) : 0;
+            n += snprintf(body + n, sizeof(body) - n, ",%02u,%02u,%03u,", 1 + s * 2, elevation, azimuth);
+            if (snr)
+               n += snprintf(body + n, sizeof(body) - n, "%02u", snr);
+         }
+         sentence(out, body);
+      }
+   }
+
+   // DDDMM.MMMMM,H
+   static void coordinate(char *text, size_t size, double value, int width, char positive, char negative)
+   {
+      double a = value < 0 ? -value : value;
+      unsigned whole = (unsigned)a;
+      snprintf(text, size, "%0*u%08.5f,%c", width, whole, (a - whole) * 60, value < 0 ? negative : positive);
+   }
+
+   // Frames body as $body*hh\r\n, possibly with a wrong checksum or cut short
+   void sentence(std::string &out, const char *body)
+   {
+      uint8_t parity = 0;
+      for (const char *p = body; *p; ++p)
+         parity ^= (uint8_t)*p;
+      if (random.below(100) < mix.badChecksumPercent)
+         parity ^= 1 + random.below(255);
+
+      char line[160];
+      int n = snprintf(line, sizeof(line), "$%s*%02X\r\n", body, parity);
+      if (random.below(100) < mix.truncatedPercent)
+         n = 1 + random.below(n - 1);
+      out.append(line, n);
+   }
+
+   navic_corpus_random random;
+   NavIC_corpus_mix mix;
+   uint32_t seconds;
+   uint32_t date;
+   double lat, lng, course, speed;
+};
+
+#endif // def(__navic_corpus_h)
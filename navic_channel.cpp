@@ -0,0 +1,72 @@
+/*
+navic_channel - lock-free latest-fix publication to other threads (host only)
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_channel.h"
+
+#ifdef _NavIC_HOST
+#include <string.h>
+
+navic_fix_channel::navic_fix_channel() : seq(0)
+{
+  for (size_t i = 0; i < WORDS; ++i)
+    data[i].store(0, std::memory_order_relaxed);
+}
+
+void navic_fix_channel::attach(navic_gn_rmc_gga &navic, uint16_t sentences)
+{
+  listener.begin(navic, onFix, this, sentences);
+}
+
+void navic_fix_channel::onFix(const NavIC_fix &fix, void *context)
+{
+  ((navic_fix_channel *)context)->publish(fix);
+}
+
+// The payload lives in relaxed atomics so that a torn read is merely
+// discarded rather than a data race; the sequence counter is odd while a
+// write is in progress
+void navic_fix_channel::publish(const NavIC_fix &fix)
+{
+  uint64_t words[WORDS] = {0};
+  memcpy(words, &fix, sizeof(fix));
+
+  uint32_t s = seq.load(std::memory_order_relaxed);
+  seq.store(s + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (size_t i = 0; i < WORDS; ++i)
+    data[i].store(words[i], std::memory_order_relaxed);
+  seq.store(s + 2, std::memory_order_release);
+}
+
+bool navic_fix_channel::read(NavIC_fix &fix) const
+{
+  uint64_t words[WORDS];
+  uint32_t before, after;
+  do
+  {
+    before = seq.load(std::memory_order_acquire);
+    if (before == 0)
+      return false;
+    if (before & 1)
+      continue;
+    for (size_t i = 0; i < WORDS; ++i)
+      words[i] = data[i].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    after = seq.load(std::memory_order_relaxed);
+  } while ((before & 1) || before != after);
+
+  memcpy(&fix, words, sizeof(fix));
+  return true;
+}
+
+#endif // _NavIC_HOST
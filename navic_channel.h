@@ -0,0 +1,55 @@
+/*
+navic_channel - lock-free latest-fix publication to other threads (host only)
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+#ifndef __navic_channel_h
+#define __navic_channel_h
+
+#include "navic_rmc_gga++.h"
+
+#ifdef _NavIC_HOST
+#include <atomic>
+
+// Seqlock around the most recent NavIC_fix.  The parsing thread publishes
+// (attach() does so from a NavIC_LISTENER at commit time) and never waits;
+// any number of reader threads get a consistent copy, retrying only if a
+// publish overlapped their read.
+class navic_fix_channel
+{
+public:
+   navic_fix_channel();
+
+   void attach(navic_gn_rmc_gga &navic, uint16_t sentences = 0);
+   void detach() { listener.end(); }
+
+   void publish(const NavIC_fix &fix); // single writer only
+
+   // latest fix; returns false if nothing has been published yet
+   bool read(NavIC_fix &fix) const;
+
+   // publishes so far; lets a reader tell whether anything is new
+   uint32_t published() const { return seq.load(std::memory_order_acquire) >> 1; }
+
+private:
+   static void onFix(const NavIC_fix &fix, void *context);
+
+   enum
+   {
+      WORDS = (sizeof(NavIC_fix) + sizeof(uint64_t) - 1) / sizeof(uint64_t)
+   };
+
+   std::atomic<uint32_t> seq;
+   std::atomic<uint64_t> data[WORDS];
+   NavIC_LISTENER listener;
+};
+
+#endif // _NavIC_HOST
+#endif // def(__navic_channel_h)
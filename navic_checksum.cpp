@@ -0,0 +1,162 @@
+/*
+navic_checksum - bulk NMEA sentence framing and checksum validation
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_checksum.h"
+#include "navic_scan.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define _NavIC_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+static uint8_t xorScalar(const char *p, size_t n, bool &lineEnd)
+{
+  uint8_t parity = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    parity ^= (uint8_t)p[i];
+    lineEnd |= p[i] == '\r' || p[i] == '\n';
+  }
+  return parity;
+}
+
+#ifdef _NavIC_X86_SIMD
+__attribute__((target("sse2"))) static uint8_t xorSSE2(const char *p, size_t n, bool &lineEnd)
+{
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+  __m128i acc = _mm_setzero_si128();
+  __m128i ends = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+    acc = _mm_xor_si128(acc, v);
+    ends = _mm_or_si128(ends, _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, lf)));
+  }
+  acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 8));
+  uint64_t folded = (uint64_t)_mm_cvtsi128_si64(acc);
+  lineEnd |= _mm_movemask_epi8(ends) != 0;
+  return navic_fold_parity(folded) ^ xorScalar(p + i, n - i, lineEnd);
+}
+
+__attribute__((target("avx2"))) static uint8_t xorAVX2(const char *p, size_t n, bool &lineEnd)
+{
+  const __m256i cr = _mm256_set1_epi8('\r');
+  const __m256i lf = _mm256_set1_epi8('\n');
+  __m256i acc = _mm256_setzero_si256();
+  __m256i ends = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32)
+  {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+    acc = _mm256_xor_si256(acc, v);
+    ends = _mm256_or_si256(ends, _mm256_or_si256(_mm256_cmpeq_epi8(v, cr), _mm256_cmpeq_epi8(v, lf)));
+  }
+  __m128i half = _mm_xor_si128(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+  half = _mm_xor_si128(half, _mm_srli_si128(half, 8));
+  uint64_t folded = (uint64_t)_mm_cvtsi128_si64(half);
+  lineEnd |= _mm256_movemask_epi8(ends) != 0;
+  return navic_fold_parity(folded) ^ xorSSE2(p + i, n - i, lineEnd);
+}
+
+typedef uint8_t (*XorKernel)(const char *p, size_t n, bool &lineEnd);
+
+static XorKernel selectKernel()
+{
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return xorAVX2;
+  if (__builtin_cpu_supports("sse2"))
+    return xorSSE2;
+  return xorScalar;
+}
+
+static const XorKernel xorKernel = selectKernel();
+#else
+static const auto xorKernel = xorScalar;
+#endif
+
+uint8_t navic_xor_bytes(const char *p, size_t n)
+{
+  bool lineEnd = false;
+  uint8_t parity = xorKernel(p, n, lineEnd);
+
+  // encode() treats CR and LF as term terminators and leaves them out of
+  // the parity; they are rare enough inside a sentence to fix up slowly
+  if (lineEnd)
+    for (size_t i = 0; i < n; ++i)
+      if (p[i] == '\r' || p[i] == '\n')
+        parity ^= (uint8_t)p[i];
+  return parity;
+}
+
+static int fromHex(char a)
+{
+  if (a >= 'A' && a <= 'F')
+    return a - 'A' + 10;
+  else if (a >= 'a' && a <= 'f')
+    return a - 'a' + 10;
+  else
+    return a - '0';
+}
+
+size_t navic_validate_checksums(const char *buf, size_t len, uint32_t &passed, uint32_t &failed)
+{
+  const char *end = buf + len;
+  const char *start = (const char *)memchr(buf, '$', len);
+
+  while (start != NULL)
+  {
+    const char *body = start + 1;
+    const char *star = (const char *)memchr(body, '*', end - body);
+    if (star == NULL)
+      return start - buf;
+
+    // A '$' before the '*' abandons the sentence, as in encode()
+    const char *restart = (const char *)memchr(body, '$', star - body);
+    if (restart != NULL)
+    {
+      start = restart;
+      continue;
+    }
+
+    uint8_t dummy = 0;
+    const char *hex = star + 1;
+    size_t hexLen = navic_scan<true, false>(hex, end - hex, dummy);
+    if (hex + hexLen == end)
+      return start - buf;
+
+    // A new sentence before the checksum term ends discards it unchecked
+    const char *next = hex + hexLen;
+    if (*next == '$')
+    {
+      start = next;
+      continue;
+    }
+
+    char h0 = hexLen > 0 ? hex[0] : '\0';
+    char h1 = hexLen > 1 ? hex[1] : '\0';
+    byte checksum = 16 * fromHex(h0) + fromHex(h1);
+    if (checksum == navic_xor_bytes(body, star - body))
+      ++passed;
+    else
+      ++failed;
+
+    start = (const char *)memchr(next, '$', end - next);
+  }
+
+  return len;
+}
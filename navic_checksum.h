@@ -0,0 +1,29 @@
+/*
+navic_checksum - bulk NMEA sentence framing and checksum validation
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+#ifndef __navic_checksum_h
+#define __navic_checksum_h
+
+#include "navic_platform.h"
+
+// XOR of every byte in p[0..n), skipping CR and LF the same way encode()
+// does.  Uses AVX2 or SSE2 where available and a scalar loop elsewhere.
+uint8_t navic_xor_bytes(const char *p, size_t n);
+
+// Frames every complete $...*HH sentence in buf and checks it, adding to
+// passed/failed.  A sentence is complete once the term following '*' has
+// been terminated, exactly as encode() would judge it.  Returns the number
+// of bytes consumed; the remainder is an unterminated sentence that should
+// be resubmitted with the next buffer.
+size_t navic_validate_checksums(const char *buf, size_t len, uint32_t &passed, uint32_t &failed);
+
+#endif // def(__navic_checksum_h)
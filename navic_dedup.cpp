@@ -0,0 +1,60 @@
+/*
+navic_dedup - cache of recent sentences, for dropping exact repeats before
+they are parsed
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_dedup.h"
+
+#include <string.h>
+
+void navic_sentence_cache::clear()
+{
+  // 0 is the hash of no sentence: hash() never returns it
+  memset(hashes, 0, sizeof(hashes));
+  next = 0;
+  suppressedCount = 0;
+}
+
+// Multiply-xorshift over 8-byte words where those loads are cheap, FNV-1a
+// over bytes elsewhere.  Every step is a bijection of the state, which
+// keeps collisions between sentences of one length at chance level.
+uint64_t navic_sentence_cache::hash(const char *p, size_t len)
+{
+  uint64_t h = (len + 1) * 0x9E3779B97F4A7C15ULL;
+#if _NavIC_SWAR
+  for (; len >= 8; p += 8, len -= 8)
+  {
+    uint64_t word;
+    memcpy(&word, p, 8);
+    h = (h ^ word) * 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 32;
+  }
+#endif
+  for (; len > 0; ++p, --len)
+    h = (h ^ (uint8_t)*p) * 0x100000001B3ULL;
+  h ^= h >> 29;
+  return h ? h : 1;
+}
+
+bool navic_sentence_cache::repeat(const char *sentence, size_t len)
+{
+  uint64_t h = hash(sentence, len);
+  for (uint8_t i = 0; i < _NavIC_DEDUP_SLOTS; ++i)
+    if (hashes[i] == h)
+    {
+      ++suppressedCount;
+      return true;
+    }
+  hashes[next] = h;
+  next = next + 1 == _NavIC_DEDUP_SLOTS ? 0 : next + 1;
+  return false;
+}
@@ -0,0 +1,52 @@
+/*
+navic_dedup - cache of recent sentences, for dropping exact repeats before
+they are parsed
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+#ifndef __navic_dedup_h
+#define __navic_dedup_h
+
+#include "navic_platform.h"
+
+#ifndef _NavIC_DEDUP_SLOTS
+#define _NavIC_DEDUP_SLOTS 16 // distinct recent sentences remembered
+#endif
+
+// 64-bit hashes of the last _NavIC_DEDUP_SLOTS distinct sentences, '$'
+// to '\n' inclusive.  Attached to a parser with navic_gn_rmc_gga::dedup(),
+// it makes the bulk encode() skip any sentence that repeats one of them
+// byte for byte: no terms are decoded, nothing is committed and the
+// checksum counters are left alone.  encode(char) never consults it.  GSV
+// sentences of more than one part are always decoded, since a sequence
+// is only taken whole.  One cache may be shared by the parsers of a
+// receiver's redundant links (from one thread), so that whichever copy
+// comes second is dropped.
+class navic_sentence_cache
+{
+public:
+   navic_sentence_cache() { clear(); }
+   void clear();
+
+   // True, and counted, if the sentence is a repeat; otherwise it is
+   // remembered in place of the oldest
+   bool repeat(const char *sentence, size_t len);
+
+   uint32_t suppressed() const { return suppressedCount; }
+
+   static uint64_t hash(const char *sentence, size_t len);
+
+private:
+   uint64_t hashes[_NavIC_DEDUP_SLOTS];
+   uint8_t next; // slot the next new sentence replaces
+   uint32_t suppressedCount;
+};
+
+#endif // def(__navic_dedup_h)
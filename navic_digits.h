@@ -0,0 +1,145 @@
+/*
+navic_digits - single-pass numeric field parsers for NMEA terms
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+#ifndef __navic_digits_h
+#define __navic_digits_h
+
+#include "navic_rmc_gga++.h"
+#include <string.h>
+
+// The parsers take Padded = true only for terms that are followed by at
+// least 8 readable bytes wherever they end, like the parser's own term
+// buffer; with _NavIC_SWAR_DIGITS those convert 8 digits at a time.
+#define _NavIC_TERM_PADDED (_NavIC_TERM_PADDING >= 8)
+
+static const uint32_t navic_pow10[10] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+static inline bool navic_is_digit(char c)
+{
+  return (uint8_t)(c - '0') < 10;
+}
+
+#ifdef _NavIC_SWAR_DIGITS
+// Number of leading ASCII digits in the 8 bytes of x (first byte lowest)
+static inline unsigned navic_swar_digit_count(uint64_t x)
+{
+  uint64_t high = (x & 0xF0F0F0F0F0F0F0F0ULL) ^ 0x3030303030303030ULL;
+  uint64_t low = ((x & 0x0F0F0F0F0F0F0F0FULL) + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL;
+  uint64_t other = high | low;
+  return other ? __builtin_ctzll(other) >> 3 : 8;
+}
+
+// Value of the first count (0..8) digits of x; shifts are split in two so
+// that none reaches 64 bits
+static inline uint32_t navic_swar_digits(uint64_t x, unsigned count)
+{
+  unsigned half = 4 * (8 - count);
+  x = ((x & 0x0F0F0F0F0F0F0F0FULL) << half) << half;
+  x = (x * 2561) >> 8;
+  x = ((x & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+  return (uint32_t)(((x & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32);
+}
+#endif
+
+// Unsigned integer at p; p is left on the first non-digit
+template <bool Padded>
+static inline uint32_t navic_parse_uint(const char *&p)
+{
+#ifdef _NavIC_SWAR_DIGITS
+  if (Padded)
+  {
+    uint64_t x;
+    memcpy(&x, p, 8);
+    unsigned count = navic_swar_digit_count(x);
+    uint32_t value = navic_swar_digits(x, count);
+    p += count;
+    while (count == 8)
+    {
+      memcpy(&x, p, 8);
+      count = navic_swar_digit_count(x);
+      value = value * navic_pow10[count] + navic_swar_digits(x, count);
+      p += count;
+    }
+    return value;
+  }
+#endif
+  uint32_t value = 0;
+  for (; navic_is_digit(*p); ++p)
+    value = value * 10 + (*p - '0');
+  return value;
+}
+
+// The first places (at most 8) digits at p, scaled by 10^places as if
+// padded with zeros; further digits are skipped.  One or two places are
+// quicker to read a byte at a time.
+template <bool Padded>
+static inline uint32_t navic_parse_fraction(const char *p, uint8_t places)
+{
+#ifdef _NavIC_SWAR_DIGITS
+  if (Padded && places > 2)
+  {
+    // zero the bytes from the first non-digit on, which then read as
+    // trailing zeros; digits past places are shifted out
+    uint64_t x;
+    memcpy(&x, p, 8);
+    unsigned count = navic_swar_digit_count(x);
+    uint64_t keep = ((1ULL << 4 * count) << 4 * count) - 1;
+    return navic_swar_digits(x & keep, places);
+  }
+#endif
+  uint32_t value = 0;
+  uint8_t i = 0;
+  for (; i < places && navic_is_digit(p[i]); ++i)
+    value = value * 10 + (p[i] - '0');
+  return value * navic_pow10[places - i];
+}
+
+// (Potentially negative) number scaled by 10^places, -xxxx.yyy
+template <bool Padded>
+static inline int32_t navic_parse_decimal(const char *p, uint8_t places)
+{
+  bool negative = *p == '-';
+  p += negative;
+  int32_t ret = (int32_t)(navic_parse_uint<Padded>(p) * navic_pow10[places]);
+  if (*p == '.')
+    ret += navic_parse_fraction<Padded>(p + 1, places);
+  return negative ? -ret : ret;
+}
+
+// Degrees in NMEA DDDMM.MMMMMMM form; minutes beyond 7 decimals are ignored
+template <bool Padded>
+static inline void navic_parse_degrees(const char *p, RawDegrees &deg)
+{
+  uint32_t leftOfDecimal = navic_parse_uint<Padded>(p);
+  uint32_t tenMillionthsOfMinutes = leftOfDecimal % 100 * 10000000UL;
+  if (*p == '.')
+    tenMillionthsOfMinutes += navic_parse_fraction<Padded>(p + 1, 7);
+
+  deg.deg = (int16_t)(leftOfDecimal / 100);
+  deg.billionths = (5 * tenMillionthsOfMinutes + 1) / 3;
+  deg.negative = false;
+}
+
+// A whole term into num, as if fed to NavIC_number::add() a character at
+// a time and finish()ed, except that only the first places (at most 7)
+// digits of the fraction are read
+template <bool Padded>
+static inline void navic_parse_number(const char *p, NavIC_number &num, uint8_t places)
+{
+  num.negative = *p == '-';
+  p += num.negative;
+  num.whole = navic_parse_uint<Padded>(p);
+  num.fraction = *p == '.' ? navic_parse_fraction<Padded>(p + 1, places) * navic_pow10[_NavIC_FRACTION_DIGITS - places] : 0;
+  num.fractionDigits = _NavIC_FRACTION_DIGITS;
+}
+
+#endif // def(__navic_digits_h)
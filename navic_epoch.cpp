@@ -0,0 +1,152 @@
+/*
+navic_epoch - merges the RMC and GGA of each UTC time into one fix record
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_epoch.h"
+
+navic_epoch_assembler::navic_epoch_assembler()
+    : callback(NULL), context(NULL), expected(_NavIC_FIX_SENTENCES), open(false), emittedAny(false), openedAt(0),
+      lastTime(0), emittedCount(0), incompleteCount(0), lateCount(0), resyncCount(0)
+{
+}
+
+void navic_epoch_assembler::begin(navic_gn_rmc_gga &navic, NavIC_epoch_callback _callback, void *_context, uint16_t _expected)
+{
+  begin(_callback, _context, _expected);
+  listener.begin(navic, onFix, this, expected);
+}
+
+void navic_epoch_assembler::begin(NavIC_epoch_callback _callback, void *_context, uint16_t _expected)
+{
+  end();
+  callback = _callback;
+  context = _context;
+  expected = _expected ? _expected : _NavIC_FIX_SENTENCES;
+  emittedAny = false;
+  lastTime = 0;
+}
+
+void navic_epoch_assembler::end()
+{
+  listener.end();
+  open = false;
+}
+
+void navic_epoch_assembler::onFix(const NavIC_fix &fix, void *context)
+{
+  static_cast<navic_epoch_assembler *>(context)->update(fix);
+}
+
+// hhmmsscc to hundredths of a second since midnight
+static uint32_t centiseconds(uint32_t time)
+{
+  return ((time / 1000000 * 60 + time / 10000 % 100) * 60 + time / 100 % 100) * 100 + time % 100;
+}
+
+static const uint32_t day = 24UL * 60 * 60 * 100;
+
+// Hundredths of a second from earlier to time, allowing for midnight
+static uint32_t ahead(uint32_t time, uint32_t earlier)
+{
+  return (centiseconds(time) + day - centiseconds(earlier)) % day;
+}
+
+// Whether time comes after earlier: anything up to half a day ahead is later
+static bool after(uint32_t time, uint32_t earlier)
+{
+  uint32_t by = ahead(time, earlier);
+  return by != 0 && by < day / 2;
+}
+
+void navic_epoch_assembler::update(const NavIC_fix &fix)
+{
+  // a sentence without a time cannot be placed in an epoch
+  if (!(fix.committed & NavIC_fix::TIME))
+    return;
+
+  if (!open || fix.time != pending.fix.time)
+  {
+    // epochs go out in time order, so one not after the newest seen is
+    // late, unless it is so far behind that the order itself has broken
+    uint32_t newest = open ? pending.fix.time : lastTime;
+    if ((open || emittedAny) && !after(fix.time, newest))
+    {
+      if (ahead(newest, fix.time) <= _NavIC_EPOCH_RESYNC * 100UL)
+      {
+        ++lateCount;
+        return;
+      }
+      ++resyncCount;
+    }
+    flush();
+    pending = NavIC_epoch();
+    open = true;
+    openedAt = navic_millis();
+  }
+
+  merge(fix);
+  if ((pending.sentences & expected) == expected)
+    flush();
+}
+
+void navic_epoch_assembler::poll()
+{
+  if (open && navic_millis() - openedAt >= _NavIC_EPOCH_WAIT)
+    flush();
+}
+
+void navic_epoch_assembler::flush()
+{
+  if (!open)
+    return;
+  open = false;
+  emittedAny = true;
+  lastTime = pending.fix.time;
+  pending.complete = (pending.sentences & expected) == expected;
+  ++emittedCount;
+  if (!pending.complete)
+    ++incompleteCount;
+  if (callback != NULL)
+    callback(pending, context);
+}
+
+// Copies what this sentence committed; a field committed twice in one
+// epoch (the location, by RMC and GGA) keeps the later value
+void navic_epoch_assembler::merge(const NavIC_fix &fix)
+{
+  NavIC_fix &to = pending.fix;
+  uint8_t committed = fix.committed;
+  if (committed & NavIC_fix::LOCATION)
+  {
+    to.lat = fix.lat;
+    to.lng = fix.lng;
+  }
+  if (committed & NavIC_fix::DATE)
+    to.date = fix.date;
+  if (committed & NavIC_fix::TIME)
+    to.time = fix.time;
+  if (committed & NavIC_fix::SPEED)
+    to.speed = fix.speed;
+  if (committed & NavIC_fix::COURSE)
+    to.course = fix.course;
+  if (committed & NavIC_fix::ALTITUDE)
+    to.altitude = fix.altitude;
+  if (committed & NavIC_fix::SATELLITES)
+    to.satellites = fix.satellites;
+  if (committed & NavIC_fix::HDOP)
+    to.hdop = fix.hdop;
+  to.sentence = fix.sentence;
+  to.talker = fix.talker;
+  to.fields |= committed;
+  to.committed |= committed;
+  pending.sentences |= _NavIC_SENTENCE_MASK(fix.sentence);
+}
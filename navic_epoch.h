@@ -0,0 +1,90 @@
+/*
+navic_epoch - merges the RMC and GGA of each UTC time into one fix record
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+#ifndef __navic_epoch_h
+#define __navic_epoch_h
+
+#include "navic_rmc_gga++.h"
+
+#ifndef _NavIC_EPOCH_WAIT
+#define _NavIC_EPOCH_WAIT 250 // ms an epoch waits for the rest of its sentences
+#endif
+#ifndef _NavIC_EPOCH_RESYNC
+#define _NavIC_EPOCH_RESYNC 5 // s behind the newest epoch at which a time restarts the order
+#endif
+
+// The fields committed by every sentence that carried one UTC time
+struct NavIC_epoch
+{
+   NavIC_fix fix;      // fields and committed cover this epoch only
+   uint16_t sentences; // _NavIC_SENTENCE_MASK() of each sentence merged
+   bool complete;      // false if emitted before all expected sentences came
+
+   NavIC_epoch() : sentences(0), complete(false)
+   {
+   }
+};
+
+typedef void (*NavIC_epoch_callback)(const NavIC_epoch &epoch, void *context);
+
+// Groups commits by fix.time and hands each epoch to the callback exactly
+// once: as soon as every expected sentence has arrived, when a sentence
+// of a later time arrives, or from poll() once _NavIC_EPOCH_WAIT has run
+// out.  Epochs go out in time order: a sentence whose time is not after
+// the open epoch's (or, with none open, the last emitted one's) is dropped
+// and counted in late(), leaving the open epoch as it was.  A time more
+// than _NavIC_EPOCH_RESYNC seconds behind is taken as the receiver
+// restarting or the input jumping instead: the open epoch is emitted and
+// the order starts again from that time, counted in resyncs().  Times wrap
+// at midnight.  Nothing is allocated.
+class navic_epoch_assembler
+{
+public:
+   navic_epoch_assembler();
+   ~navic_epoch_assembler() { end(); }
+
+   // expected: the sentences that complete an epoch, 0 for RMC and GGA
+   void begin(navic_gn_rmc_gga &navic, NavIC_epoch_callback callback, void *context = 0, uint16_t expected = 0);
+   // for commits fed to update() from elsewhere
+   void begin(NavIC_epoch_callback callback, void *context = 0, uint16_t expected = 0);
+   void end(); // stop listening; a pending epoch is dropped
+
+   void update(const NavIC_fix &fix); // feeds one commit
+   void poll();                       // call from loop() to bound the wait
+   void flush();                      // emit the pending epoch now
+
+   uint32_t emitted() const { return emittedCount; }
+   uint32_t incomplete() const { return incompleteCount; }
+   uint32_t late() const { return lateCount; }
+   uint32_t resyncs() const { return resyncCount; }
+
+private:
+   navic_epoch_assembler(const navic_epoch_assembler &);
+   navic_epoch_assembler &operator=(const navic_epoch_assembler &);
+
+   static void onFix(const NavIC_fix &fix, void *context);
+   void merge(const NavIC_fix &fix);
+
+   NavIC_LISTENER listener;
+   NavIC_epoch_callback callback;
+   void *context;
+   uint16_t expected;
+
+   NavIC_epoch pending;
+   bool open, emittedAny;
+   uint32_t openedAt;  // navic_millis() at the epoch's first sentence
+   uint32_t lastTime;  // fix.time of the last epoch emitted
+
+   uint32_t emittedCount, incompleteCount, lateCount, resyncCount;
+};
+
+#endif // def(__navic_epoch_h)
@@ -0,0 +1,305 @@
+/*
+navic_fence - grid index for testing fixes against many circular
+geofences, with per-stream enter/exit events (host only)
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_fence.h"
+
+#ifdef _NavIC_HOST
+#include <math.h>
+#include <algorithm>
+#include <utility>
+
+#define _NavIC_METERS_PER_E7 (6372795.0 * PI / 180 / 1e7) // on the distanceBetween() sphere
+#define _NavIC_E7_TURN 3600000000LL
+
+static int32_t wrapLng(int64_t lng)
+{
+  if (lng >= _NavIC_E7_TURN / 2)
+    lng -= _NavIC_E7_TURN;
+  else if (lng < -_NavIC_E7_TURN / 2)
+    lng += _NavIC_E7_TURN;
+  return (int32_t)lng;
+}
+
+static uint64_t hashCell(uint64_t key)
+{
+  return (key * 0x9E3779B97F4A7C15ULL) >> 24;
+}
+
+navic_fence_index::navic_fence_index(uint32_t cellMeters) : slotMask(0)
+{
+  double e7 = (cellMeters ? cellMeters : 1) / _NavIC_METERS_PER_E7;
+  // whole columns around the globe, so that longitudes wrap onto cells
+  columns = (uint32_t)(_NavIC_E7_TURN / e7);
+  if (columns == 0)
+    columns = 1;
+  step = (int32_t)((_NavIC_E7_TURN + columns - 1) / columns);
+}
+
+void navic_fence_index::add(uint32_t id, int32_t latE7, int32_t lngE7, uint32_t radiusMeters)
+{
+  Fence f;
+  f.id = id;
+  f.lat = latE7;
+  f.lng = wrapLng(lngE7);
+  f.radius = radiusMeters;
+  fences.push_back(f);
+}
+
+uint64_t navic_fence_index::cellOf(int32_t lat, int32_t lng) const
+{
+  uint64_t row = (uint64_t)((int64_t)lat + _NavIC_E7_TURN / 4) / step;
+  uint64_t col = (uint64_t)((int64_t)wrapLng(lng) + _NavIC_E7_TURN / 2) / step;
+  return row * columns + col;
+}
+
+void navic_fence_index::build()
+{
+  // (cell, fence) for every cell each fence's bounding box touches
+  std::vector<std::pair<uint64_t, uint32_t> > cells;
+  wide.clear();
+  for (uint32_t i = 0; i < fences.size(); ++i)
+  {
+    const Fence &f = fences[i];
+    int64_t dLat = (int64_t)(f.radius / _NavIC_METERS_PER_E7) + 1;
+    int64_t south = std::max((int64_t)f.lat - dLat, (int64_t)(-_NavIC_E7_TURN / 4));
+    int64_t north = std::min((int64_t)f.lat + dLat, (int64_t)(_NavIC_E7_TURN / 4));
+
+    // longitude span at the bounding box's widest latitude; all the way
+    // round if it reaches a pole
+    double widest = std::max(fabs((double)south), fabs((double)north)) / 1e7;
+    double c = cos(widest * DEG_TO_RAD);
+    int64_t dLng = c > 1e-6 ? (int64_t)(f.radius / (_NavIC_METERS_PER_E7 * c)) + 1 : _NavIC_E7_TURN;
+    bool allColumns = dLng >= _NavIC_E7_TURN / 2;
+
+    uint64_t firstRow = (uint64_t)(south + _NavIC_E7_TURN / 4) / step;
+    uint64_t lastRow = (uint64_t)(north + _NavIC_E7_TURN / 4) / step;
+    uint64_t westCol = (uint64_t)((int64_t)wrapLng(f.lng - dLng) + _NavIC_E7_TURN / 2) / step;
+    uint64_t eastCol = (uint64_t)((int64_t)wrapLng(f.lng + dLng) + _NavIC_E7_TURN / 2) / step;
+    if (allColumns)
+    {
+      westCol = 0;
+      eastCol = columns - 1;
+    }
+    uint64_t span = (lastRow - firstRow + 1) * ((eastCol + columns - westCol) % columns + 1);
+    if (allColumns || span > _NavIC_FENCE_MAX_CELLS || south < -_NavIC_FENCE_POLAR_E7 || north > _NavIC_FENCE_POLAR_E7)
+    {
+      wide.push_back(f);
+      continue;
+    }
+    for (uint64_t row = firstRow; row <= lastRow; ++row)
+    {
+      // the box may cross the antimeridian, in which case it wraps
+      for (uint64_t col = westCol;; col = col + 1 == columns ? 0 : col + 1)
+      {
+        cells.push_back(std::make_pair(row * columns + col, i));
+        if (col == eastCol)
+          break;
+      }
+    }
+  }
+  std::sort(cells.begin(), cells.end());
+
+  size_t distinct = 0;
+  for (size_t i = 0; i < cells.size(); ++i)
+    distinct += i == 0 || cells[i].first != cells[i - 1].first;
+  size_t capacity = 16;
+  while (capacity < 2 * distinct)
+    capacity *= 2;
+  slots.assign(capacity, Slot());
+  for (size_t i = 0; i < capacity; ++i)
+    slots[i].key = 0;
+  slotMask = capacity - 1;
+
+  entries.clear();
+  entries.reserve(cells.size());
+  Slot *slot = NULL;
+  for (size_t i = 0; i < cells.size(); ++i)
+  {
+    if (i == 0 || cells[i].first != cells[i - 1].first)
+    {
+      uint64_t h = hashCell(cells[i].first) & slotMask;
+      while (slots[h].key != 0)
+        h = (h + 1) & slotMask;
+      slot = &slots[h];
+      slot->key = cells[i].first + 1;
+      slot->first = (uint32_t)entries.size();
+      slot->count = 0;
+    }
+
+    const Fence &f = fences[cells[i].second];
+    Entry e;
+    e.lat = f.lat;
+    e.lng = f.lng;
+    double phi = f.lat / 1e7 * DEG_TO_RAD;
+    e.eastScale = (float)(_NavIC_METERS_PER_E7 * cos(phi));
+    e.eastSlope = (float)(_NavIC_METERS_PER_E7 * sin(phi) * DEG_TO_RAD / 1e7 / 2);
+    e.radius2 = (float)f.radius * (float)f.radius;
+    e.id = f.id;
+    entries.push_back(e);
+    ++slot->count;
+  }
+}
+
+const navic_fence_index::Slot *navic_fence_index::find(uint64_t key) const
+{
+  if (slots.empty())
+    return NULL;
+  for (uint64_t h = hashCell(key) & slotMask;; h = (h + 1) & slotMask)
+  {
+    if (slots[h].key == key + 1)
+      return &slots[h];
+    if (slots[h].key == 0)
+      return NULL;
+  }
+}
+
+size_t navic_fence_index::test(const Slot *slot, int32_t lat, int32_t lng, std::vector<uint32_t> &ids) const
+{
+  if (slot == NULL)
+    return 0;
+  size_t found = 0;
+  const Entry *e = &entries[slot->first];
+  for (uint32_t i = 0; i < slot->count; ++i, ++e)
+  {
+    // the east scale is taken halfway between center and point
+    float dLat = (float)((int64_t)lat - e->lat);
+    float north = dLat * (float)_NavIC_METERS_PER_E7;
+    float east = (float)wrapLng((int64_t)lng - e->lng) * (e->eastScale - e->eastSlope * dLat);
+    if (north * north + east * east <= e->radius2)
+    {
+      ids.push_back(e->id);
+      ++found;
+    }
+  }
+  return found;
+}
+
+size_t navic_fence_index::testWide(int32_t lat, int32_t lng, std::vector<uint32_t> &ids) const
+{
+  size_t found = 0;
+  for (size_t i = 0; i < wide.size(); ++i)
+  {
+    const Fence &f = wide[i];
+    if (navic_gn_rmc_gga::distanceBetween(lat / 1e7, lng / 1e7, f.lat / 1e7, f.lng / 1e7) <= f.radius)
+    {
+      ids.push_back(f.id);
+      ++found;
+    }
+  }
+  return found;
+}
+
+size_t navic_fence_index::query(int32_t latE7, int32_t lngE7, std::vector<uint32_t> &ids) const
+{
+  size_t found = test(find(cellOf(latE7, lngE7)), latE7, lngE7, ids);
+  if (!wide.empty())
+    found += testWide(latE7, lngE7, ids);
+  return found;
+}
+
+void navic_fence_index::query(const int32_t *latE7, const int32_t *lngE7, size_t n,
+                              std::vector<uint32_t> &ids, std::vector<uint32_t> &offsets) const
+{
+  ids.clear();
+  offsets.resize(n + 1);
+  offsets[0] = 0;
+  // consecutive fixes of a track mostly stay in one cell, whose lookup is
+  // then reused
+  uint64_t lastKey = ~(uint64_t)0;
+  const Slot *slot = NULL;
+  for (size_t i = 0; i < n; ++i)
+  {
+    uint64_t key = cellOf(latE7[i], lngE7[i]);
+    if (key != lastKey)
+    {
+      slot = find(key);
+      lastKey = key;
+    }
+    test(slot, latE7[i], lngE7[i], ids);
+    if (!wide.empty())
+      testWide(latE7[i], lngE7[i], ids);
+    offsets[i + 1] = (uint32_t)ids.size();
+  }
+}
+
+navic_fence_monitor::navic_fence_monitor(const navic_fence_index &index, uint32_t streams)
+    : index(index), insideOf(streams)
+{
+}
+
+size_t navic_fence_monitor::changes(uint32_t stream, std::vector<uint32_t>::iterator first,
+                                    std::vector<uint32_t>::iterator last, std::vector<NavIC_fence_event> &events)
+{
+  std::sort(first, last);
+  std::vector<uint32_t> &was = insideOf[stream];
+  size_t before = events.size();
+  NavIC_fence_event event;
+  event.stream = stream;
+
+  event.entered = false;
+  std::vector<uint32_t>::iterator now = first;
+  for (size_t i = 0; i < was.size(); ++i)
+  {
+    while (now != last && *now < was[i])
+      ++now;
+    if (now == last || *now != was[i])
+    {
+      event.fence = was[i];
+      events.push_back(event);
+    }
+  }
+
+  event.entered = true;
+  size_t j = 0;
+  for (now = first; now != last; ++now)
+  {
+    while (j < was.size() && was[j] < *now)
+      ++j;
+    if (j == was.size() || was[j] != *now)
+    {
+      event.fence = *now;
+      events.push_back(event);
+    }
+  }
+
+  if (events.size() != before)
+    was.assign(first, last);
+  return events.size() - before;
+}
+
+size_t navic_fence_monitor::update(uint32_t stream, int32_t latE7, int32_t lngE7, std::vector<NavIC_fence_event> &events)
+{
+  found.clear();
+  index.query(latE7, lngE7, found);
+  return changes(stream, found.begin(), found.end(), events);
+}
+
+size_t navic_fence_monitor::update(uint32_t stream, const NavIC_fix &fix, std::vector<NavIC_fence_event> &events)
+{
+  if (!(fix.fields & NavIC_fix::LOCATION))
+    return 0;
+  return update(stream, fix.lat.e7(), fix.lng.e7(), events);
+}
+
+size_t navic_fence_monitor::update(const uint32_t *streams, const int32_t *latE7, const int32_t *lngE7, size_t n,
+                                   std::vector<NavIC_fence_event> &events)
+{
+  index.query(latE7, lngE7, n, found, offsets);
+  size_t count = 0;
+  for (size_t i = 0; i < n; ++i)
+    count += changes(streams[i], found.begin() + offsets[i], found.begin() + offsets[i + 1], events);
+  return count;
+}
+
+#endif // _NavIC_HOST
@@ -0,0 +1,144 @@
+/*
+navic_fence - grid index for testing fixes against many circular
+geofences, with per-stream enter/exit events (host only)
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+#ifndef __navic_fence_h
+#define __navic_fence_h
+
+#include "navic_rmc_gga++.h"
+
+#ifdef _NavIC_HOST
+#include <vector>
+
+#define _NavIC_FENCE_CELL_METERS 1000 // default grid spacing, about the typical fence radius
+#ifndef _NavIC_FENCE_MAX_CELLS
+#define _NavIC_FENCE_MAX_CELLS 64 // cells a fence may be copied into before it is kept aside
+#endif
+#define _NavIC_FENCE_POLAR_E7 800000000 // 80 degrees; fences reaching beyond are kept aside
+
+// Circular fences on a grid of square cells in degrees * 10^7.  Each fence
+// is copied into every cell its bounding box touches, so a query hashes
+// the point's cell and then tests only the fences stored contiguously
+// there.  Distances use the local flat-earth approximation at the mean
+// latitude of point and center: within a few centimeters of
+// distanceBetween() for fences of a few kilometers, and 0.03% of the
+// radius up to 100 km.
+//
+// A fence whose box covers more than _NavIC_FENCE_MAX_CELLS cells, or
+// reaches beyond 80 degrees of latitude where meridians converge too fast
+// for the approximation, is kept on a side list instead.  Every query
+// tests all of those with distanceBetween() itself, so they should stay
+// few.
+//
+// Fences are add()ed, then build() makes the index; adding more needs
+// another build().  Queries are const and may run from many threads.
+class navic_fence_index
+{
+public:
+   explicit navic_fence_index(uint32_t cellMeters = _NavIC_FENCE_CELL_METERS);
+
+   void add(uint32_t id, int32_t latE7, int32_t lngE7, uint32_t radiusMeters);
+   void add(uint32_t id, const RawDegrees &lat, const RawDegrees &lng, uint32_t radiusMeters)
+   {
+      add(id, lat.e7(), lng.e7(), radiusMeters);
+   }
+   void build();
+   size_t size() const { return fences.size(); }
+
+   // Appends the ids of the fences containing the point to ids; returns
+   // how many
+   size_t query(int32_t latE7, int32_t lngE7, std::vector<uint32_t> &ids) const;
+   size_t query(const RawDegrees &lat, const RawDegrees &lng, std::vector<uint32_t> &ids) const
+   {
+      return query(lat.e7(), lng.e7(), ids);
+   }
+
+   // Batch form: the fences containing point i end up in
+   // ids[offsets[i]..offsets[i + 1]); both vectors are replaced
+   void query(const int32_t *latE7, const int32_t *lngE7, size_t n,
+              std::vector<uint32_t> &ids, std::vector<uint32_t> &offsets) const;
+
+private:
+   struct Fence
+   {
+      uint32_t id;
+      int32_t lat, lng;
+      uint32_t radius;
+   };
+
+   // a fence as stored in each of its cells, 24 bytes
+   struct Entry
+   {
+      int32_t lat, lng;
+      float eastScale; // meters per 10^-7 degree of longitude at lat
+      float eastSlope; // its change per 10^-7 degree of latitude, halved
+      float radius2;   // square meters
+      uint32_t id;
+   };
+
+   struct Slot
+   {
+      uint64_t key; // cell key + 1, 0 for an empty slot
+      uint32_t first, count;
+   };
+
+   int32_t step; // cell side in degrees * 10^7
+   uint32_t columns;
+   std::vector<Fence> fences;
+   std::vector<Fence> wide;    // large and polar fences, tested on every query
+   std::vector<Entry> entries; // grouped by cell
+   std::vector<Slot> slots;    // open addressing on the cell key
+   uint64_t slotMask;
+
+   uint64_t cellOf(int32_t lat, int32_t lng) const;
+   const Slot *find(uint64_t key) const;
+   size_t test(const Slot *slot, int32_t lat, int32_t lng, std::vector<uint32_t> &ids) const;
+   size_t testWide(int32_t lat, int32_t lng, std::vector<uint32_t> &ids) const;
+};
+
+struct NavIC_fence_event
+{
+   uint32_t stream;
+   uint32_t fence; // id passed to navic_fence_index::add()
+   bool entered;   // false when the stream left the fence
+};
+
+// The fences each of a fixed number of streams is inside, updated fix by
+// fix; update() reports only the changes.
+class navic_fence_monitor
+{
+public:
+   navic_fence_monitor(const navic_fence_index &index, uint32_t streams);
+
+   // Moves stream to the point and appends its enter/exit events, exits
+   // first; returns how many were appended
+   size_t update(uint32_t stream, int32_t latE7, int32_t lngE7, std::vector<NavIC_fence_event> &events);
+   // Ignores fixes that hold no location
+   size_t update(uint32_t stream, const NavIC_fix &fix, std::vector<NavIC_fence_event> &events);
+   // Points of several streams at once, e.g. the fixes of one decode pass
+   size_t update(const uint32_t *streams, const int32_t *latE7, const int32_t *lngE7, size_t n,
+                 std::vector<NavIC_fence_event> &events);
+
+   const std::vector<uint32_t> &inside(uint32_t stream) const { return insideOf[stream]; } // sorted ids
+   void reset(uint32_t stream) { insideOf[stream].clear(); }
+
+private:
+   const navic_fence_index &index;
+   std::vector<std::vector<uint32_t> > insideOf;
+   std::vector<uint32_t> found, offsets;
+
+   size_t changes(uint32_t stream, std::vector<uint32_t>::iterator first, std::vector<uint32_t>::iterator last,
+                  std::vector<NavIC_fence_event> &events);
+};
+
+#endif // _NavIC_HOST
+#endif // def(__navic_fence_h)
@@ -0,0 +1,259 @@
+/*
+navic_geo - batch great-circle distance and course over arrays (host only)
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_geo.h"
+
+#ifdef _NavIC_HOST
+#include <math.h>
+
+// Set to 0 to always run the generic kernels, as on CPUs without AVX2
+#ifndef _NavIC_GEO_SIMD
+#if defined(__GNUC__) && defined(__x86_64__)
+#define _NavIC_GEO_SIMD 1
+#else
+#define _NavIC_GEO_SIMD 0
+#endif
+#endif
+
+#ifdef __GNUC__
+// the loops are instantiated once per instruction set below, and must be
+// inlined into each to be compiled for it
+#define _NavIC_GEO_INLINE inline __attribute__((always_inline))
+#else
+#define _NavIC_GEO_INLINE inline
+#endif
+
+#define _NavIC_EARTH_RADIUS 6372795.0 // meters, as in distanceBetween()
+#define _NavIC_TRACK_BLOCK 256
+
+// Everything below is written without branches so that the loops over
+// arrays vectorise; conditionals are selects on values that are computed
+// either way.  The build turns off -ftrapping-math for this file, without
+// which GCC will not turn those selects into vector blends.
+
+// Round to nearest integer for |x| < 2^51 by pushing the fraction out of
+// the mantissa
+static _NavIC_GEO_INLINE double roundNearest(double x)
+{
+  const double magic = 6755399441055744.0; // 1.5 * 2^52
+  return (x + magic) - magic;
+}
+
+template <int Accuracy>
+static _NavIC_GEO_INLINE void sinCos(double x, double &s, double &c)
+{
+  // Reduce to r in [-pi/4, pi/4] and quadrant m, with pi/2 split in two
+  // parts so the reduction itself loses no precision
+  const double pio2Hi = 1.57079632673412561417;
+  const double pio2Lo = 6.07710050650619224932e-11;
+  double q = roundNearest(x * (2 / PI));
+  double r = (x - q * pio2Hi) - q * pio2Lo;
+  double m = q - 4 * roundNearest(q * 0.25 - 0.375);
+  double r2 = r * r;
+
+  double sr, cr;
+  if (Accuracy == NAVIC_GEO_PRECISE)
+  {
+    sr = r + r * r2 * (-1 / 6.0 + r2 * (1 / 120.0 + r2 * (-1 / 5040.0 + r2 * (1 / 362880.0 + r2 * (-1 / 39916800.0)))));
+    cr = 1 + r2 * (-1 / 2.0 + r2 * (1 / 24.0 + r2 * (-1 / 720.0 + r2 * (1 / 40320.0 + r2 * (-1 / 3628800.0 + r2 * (1 / 479001600.0))))));
+  }
+  else
+  {
+    // short of these terms the error at the ends of the range, where
+    // neighbouring latitudes fall either side of a quadrant, is a few meters
+    sr = r + r * r2 * (-1 / 6.0 + r2 * (1 / 120.0 + r2 * (-1 / 5040.0 + r2 * (1 / 362880.0))));
+    cr = 1 + r2 * (-1 / 2.0 + r2 * (1 / 24.0 + r2 * (-1 / 720.0 + r2 * (1 / 40320.0 + r2 * (-1 / 3628800.0)))));
+  }
+
+  bool swap = m == 1 || m == 3;
+  double s0 = swap ? cr : sr;
+  double c0 = swap ? sr : cr;
+  s = m >= 2 ? -s0 : s0;
+  c = m == 1 || m == 2 ? -c0 : c0;
+}
+
+template <int Accuracy>
+static _NavIC_GEO_INLINE double atan2Poly(double y, double x)
+{
+  double ax = fabs(x), ay = fabs(y);
+  double hi = ax > ay ? ax : ay;
+  double lo = ax > ay ? ay : ax;
+  // atan(t) = pi/4 + atan((t - 1) / (t + 1)) keeps the argument below
+  // tan(pi/8); with t = lo / hi both cases need a single division
+  bool big = lo > 0.41421356237309504880 * hi;
+  double num = big ? lo - hi : lo;
+  double den = big ? lo + hi : (hi > 0 ? hi : 1);
+  double u = num / den;
+  double z = u * u;
+  double a;
+  if (Accuracy == NAVIC_GEO_PRECISE)
+  {
+    // Cephes rational approximation, good to double precision for |u| < 0.66
+    double p = (((-8.750608600031904122785e-1 * z - 1.615753718733365076637e1) * z - 7.500855792314704667340e1) * z - 1.228866684490136173410e2) * z - 6.485021904942025371773e1;
+    double q = ((((z + 2.485846490142306297962e1) * z + 1.650270098316988542046e2) * z + 4.328810604912902668951e2) * z + 4.853903996359136964868e2) * z + 1.945506571482613964425e2;
+    a = u + u * z * p / q;
+  }
+  else
+    a = u + u * z * (-1 / 3.0 + z * (1 / 5.0 + z * (-1 / 7.0 + z * (1 / 9.0 + z * (-1 / 11.0)))));
+
+  a += big ? PI / 4 : 0;
+  a = ay > ax ? PI / 2 - a : a;
+  a = x < 0 ? PI - a : a;
+  return y < 0 ? -a : a;
+}
+
+template <int Accuracy>
+static _NavIC_GEO_INLINE double distance(double slat1, double clat1, double slat2, double clat2, double dlong)
+{
+  double sdlong, cdlong;
+  sinCos<Accuracy>(dlong * DEG_TO_RAD, sdlong, cdlong);
+  double a = (clat1 * slat2) - (slat1 * clat2 * cdlong);
+  double b = clat2 * sdlong;
+  double denom = (slat1 * slat2) + (clat1 * clat2 * cdlong);
+  return atan2Poly<Accuracy>(sqrt(a * a + b * b), denom) * _NavIC_EARTH_RADIUS;
+}
+
+template <int Accuracy>
+static _NavIC_GEO_INLINE void distanceBatch(const double *__restrict lat1, const double *__restrict lng1,
+                          const double *__restrict lat2, const double *__restrict lng2,
+                          double *__restrict meters, size_t n)
+{
+  for (size_t i = 0; i < n; ++i)
+  {
+    double slat1, clat1, slat2, clat2;
+    sinCos<Accuracy>(lat1[i] * DEG_TO_RAD, slat1, clat1);
+    sinCos<Accuracy>(lat2[i] * DEG_TO_RAD, slat2, clat2);
+    meters[i] = distance<Accuracy>(slat1, clat1, slat2, clat2, lng1[i] - lng2[i]);
+  }
+}
+
+template <int Accuracy>
+static _NavIC_GEO_INLINE void courseBatch(const double *__restrict lat1, const double *__restrict lng1,
+                        const double *__restrict lat2, const double *__restrict lng2,
+                        double *__restrict degrees, size_t n)
+{
+  for (size_t i = 0; i < n; ++i)
+  {
+    double slat1, clat1, slat2, clat2, sdlon, cdlon;
+    sinCos<Accuracy>(lat1[i] * DEG_TO_RAD, slat1, clat1);
+    sinCos<Accuracy>(lat2[i] * DEG_TO_RAD, slat2, clat2);
+    sinCos<Accuracy>((lng2[i] - lng1[i]) * DEG_TO_RAD, sdlon, cdlon);
+    double a1 = sdlon * clat2;
+    double a2 = clat1 * slat2 - slat1 * clat2 * cdlon;
+    double course = atan2Poly<Accuracy>(a1, a2);
+    course = course < 0 ? course + TWO_PI : course;
+    // a fused multiply-add can leave a2 a rounding error below zero for
+    // coincident points, and a course a rounding error below zero 360
+    double deg = course * RAD_TO_DEG;
+    deg = deg < 360 ? deg : 0;
+    degrees[i] = lat1[i] == lat2[i] && sdlon == 0 ? 0 : deg;
+  }
+}
+
+template <int Accuracy>
+static _NavIC_GEO_INLINE void trackSegments(const double *__restrict lat, const double *__restrict lng, size_t n, double *__restrict meters)
+{
+  double slat[_NavIC_TRACK_BLOCK + 1], clat[_NavIC_TRACK_BLOCK + 1];
+
+  // Blocks overlap by one point so each latitude is only reduced once
+  for (size_t base = 0; base + 1 < n; base += _NavIC_TRACK_BLOCK)
+  {
+    size_t points = n - base < _NavIC_TRACK_BLOCK + 1 ? n - base : _NavIC_TRACK_BLOCK + 1;
+    for (size_t i = 0; i < points; ++i)
+      sinCos<Accuracy>(lat[base + i] * DEG_TO_RAD, slat[i], clat[i]);
+    for (size_t i = 0; i + 1 < points; ++i)
+      meters[base + i] = distance<Accuracy>(slat[i], clat[i], slat[i + 1], clat[i + 1], lng[base + i] - lng[base + i + 1]);
+  }
+}
+
+#define _NavIC_GEO_KERNELS(suffix)                                                                       \
+  static void distance##suffix(const double *lat1, const double *lng1, const double *lat2, const double *lng2, \
+                               double *meters, size_t n, NavIC_geo_accuracy accuracy)                  \
+  {                                                                                                    \
+    if (accuracy == NAVIC_GEO_FAST)                                                                    \
+      distanceBatch<NAVIC_GEO_FAST>(lat1, lng1, lat2, lng2, meters, n);                                \
+    else                                                                                               \
+      distanceBatch<NAVIC_GEO_PRECISE>(lat1, lng1, lat2, lng2, meters, n);                             \
+  }                                                                                                    \
+  static void course##suffix(const double *lat1, const double *lng1, const double *lat2, const double *lng2, \
+                             double *degrees, size_t n, NavIC_geo_accuracy accuracy)                   \
+  {                                                                                                    \
+    if (accuracy == NAVIC_GEO_FAST)                                                                    \
+      courseBatch<NAVIC_GEO_FAST>(lat1, lng1, lat2, lng2, degrees, n);                                 \
+    else                                                                                               \
+      courseBatch<NAVIC_GEO_PRECISE>(lat1, lng1, lat2, lng2, degrees, n);                              \
+  }                                                                                                    \
+  static void track##suffix(const double *lat, const double *lng, size_t n, double *meters,            \
+                            NavIC_geo_accuracy accuracy)                                               \
+  {                                                                                                    \
+    if (accuracy == NAVIC_GEO_FAST)                                                                    \
+      trackSegments<NAVIC_GEO_FAST>(lat, lng, n, meters);                                              \
+    else                                                                                               \
+      trackSegments<NAVIC_GEO_PRECISE>(lat, lng, n, meters);                                           \
+  }
+
+_NavIC_GEO_KERNELS(Generic)
+
+#if _NavIC_GEO_SIMD
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+_NavIC_GEO_KERNELS(AVX2)
+#pragma GCC pop_options
+
+static bool selectAVX2()
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+static const bool useAVX2 = selectAVX2();
+#else
+static const bool useAVX2 = false;
+#define distanceAVX2 distanceGeneric
+#define courseAVX2 courseGeneric
+#define trackAVX2 trackGeneric
+#endif
+
+void navic_distance_batch(const double *lat1, const double *lng1, const double *lat2, const double *lng2,
+                          double *meters, size_t n, NavIC_geo_accuracy accuracy)
+{
+  (useAVX2 ? distanceAVX2 : distanceGeneric)(lat1, lng1, lat2, lng2, meters, n, accuracy);
+}
+
+void navic_course_batch(const double *lat1, const double *lng1, const double *lat2, const double *lng2,
+                        double *degrees, size_t n, NavIC_geo_accuracy accuracy)
+{
+  (useAVX2 ? courseAVX2 : courseGeneric)(lat1, lng1, lat2, lng2, degrees, n, accuracy);
+}
+
+void navic_track_segments(const double *lat, const double *lng, size_t n, double *meters, NavIC_geo_accuracy accuracy)
+{
+  (useAVX2 ? trackAVX2 : trackGeneric)(lat, lng, n, meters, accuracy);
+}
+
+double navic_track_length(const double *lat, const double *lng, size_t n, NavIC_geo_accuracy accuracy)
+{
+  double segments[_NavIC_TRACK_BLOCK];
+  double total = 0;
+  // Chunks share their boundary point, so the sum covers every segment once
+  for (size_t base = 0; base + 1 < n; base += _NavIC_TRACK_BLOCK)
+  {
+    size_t points = n - base < _NavIC_TRACK_BLOCK + 1 ? n - base : _NavIC_TRACK_BLOCK + 1;
+    navic_track_segments(lat + base, lng + base, points, segments, accuracy);
+    for (size_t i = 0; i + 1 < points; ++i)
+      total += segments[i];
+  }
+  return total;
+}
+
+#endif // _NavIC_HOST
@@ -0,0 +1,45 @@
+/*
+navic_geo - batch great-circle distance and course over arrays (host only)
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+#ifndef __navic_geo_h
+#define __navic_geo_h
+
+#include "navic_rmc_gga++.h"
+
+#ifdef _NavIC_HOST
+
+// Same formulas as navic_gn_rmc_gga::distanceBetween() and courseTo(), with
+// sin/cos/atan2 replaced by branch-free polynomials the compiler can
+// vectorise.  NAVIC_GEO_FAST stays within a few meters of the scalar
+// versions, NAVIC_GEO_PRECISE within a millimeter.
+enum NavIC_geo_accuracy
+{
+   NAVIC_GEO_FAST,
+   NAVIC_GEO_PRECISE
+};
+
+// Inputs are signed decimal degrees in separate lat/lng arrays.
+void navic_distance_batch(const double *lat1, const double *lng1, const double *lat2, const double *lng2,
+                          double *meters, size_t n, NavIC_geo_accuracy accuracy = NAVIC_GEO_PRECISE);
+void navic_course_batch(const double *lat1, const double *lng1, const double *lat2, const double *lng2,
+                        double *degrees, size_t n, NavIC_geo_accuracy accuracy = NAVIC_GEO_PRECISE);
+
+// Distances between consecutive points of a track (n - 1 results); the
+// sine and cosine of each latitude are computed once and used for both
+// segments that share the point.
+void navic_track_segments(const double *lat, const double *lng, size_t n,
+                          double *meters, NavIC_geo_accuracy accuracy = NAVIC_GEO_PRECISE);
+double navic_track_length(const double *lat, const double *lng, size_t n,
+                          NavIC_geo_accuracy accuracy = NAVIC_GEO_PRECISE);
+
+#endif // _NavIC_HOST
+#endif // def(__navic_geo_h)
@@ -0,0 +1,412 @@
+/*
+navic_ingest - epoll server decoding NMEA streamed over TCP and UDP by many
+receivers at once (Linux hosts only)
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_ingest.h"
+
+#if defined(_NavIC_HOST) && defined(__linux__)
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#define _NavIC_INGEST_EVENTS 256
+#define _NavIC_INGEST_DATAGRAM 2048   // longer datagrams are cut short
+#define _NavIC_INGEST_UDP_ROUNDS 8    // recvmmsg() batches per wakeup, so TCP is not starved
+#define _NavIC_INGEST_SWEEP_MS 1000
+#define _NavIC_INGEST_UDP_BUFFER (4 << 20) // receive buffer asked for, to ride out bursts; capped by rmem_max
+
+namespace
+{
+struct Source
+{
+  NavIC_ingest_source info;
+  int fd;       // -1 for a UDP sender
+  size_t index; // in Reactor::sources
+  uint32_t lastMs;
+  std::string key; // UDP sender address
+  NavIC_ingest_callback callback;
+  void *context;
+  navic_gn_rmc_gga navic;
+  NavIC_LISTENER listener;
+};
+
+void onFix(const NavIC_fix &fix, void *context)
+{
+  Source *s = (Source *)context;
+  s->callback(s->info, fix, s->context);
+}
+
+// Counters have a single writer, the reactor thread, so a plain
+// load/store pair is enough and avoids a locked add
+void add(std::atomic<uint64_t> &counter, uint64_t n)
+{
+  counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+// port and address only; sin_zero and flow labels do not identify a sender
+std::string peerKey(const sockaddr_storage &peer)
+{
+  if (peer.ss_family == AF_INET6)
+  {
+    const sockaddr_in6 *a = (const sockaddr_in6 *)&peer;
+    return std::string((const char *)&a->sin6_port, 2) + std::string((const char *)&a->sin6_addr, 16);
+  }
+  const sockaddr_in *a = (const sockaddr_in *)&peer;
+  return std::string((const char *)&a->sin_port, 2) + std::string((const char *)&a->sin_addr, 4);
+}
+}
+
+struct navic_ingest_server::Reactor
+{
+  int epoll, wake, tcp, udp;
+  uint64_t idBase, serial;
+  uint32_t maxSources, idleMs;
+  NavIC_ingest_callback callback;
+  void *context;
+  uint16_t sentences;
+
+  std::vector<Source *> sources;
+  std::unordered_map<std::string, Source *> senders;
+  std::vector<char> buffer;
+  std::thread thread;
+
+  std::atomic<uint64_t> accepted, refused, closed, bytes, datagrams, passed, failed;
+
+  Reactor(unsigned index, uint32_t maxSources, uint32_t idleMs, NavIC_ingest_callback callback, void *context,
+          uint16_t sentences)
+      : tcp(-1), udp(-1), idBase((uint64_t)index << 48), serial(0), maxSources(maxSources), idleMs(idleMs),
+        callback(callback), context(context), sentences(sentences),
+        buffer(_NavIC_INGEST_READ_SIZE > _NavIC_INGEST_UDP_BATCH * _NavIC_INGEST_DATAGRAM
+                   ? _NavIC_INGEST_READ_SIZE
+                   : _NavIC_INGEST_UDP_BATCH * _NavIC_INGEST_DATAGRAM),
+        accepted(0), refused(0), closed(0), bytes(0), datagrams(0), passed(0), failed(0)
+  {
+    epoll = epoll_create1(EPOLL_CLOEXEC);
+    wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll >= 0 && wake >= 0)
+      watch(wake, &wake);
+  }
+
+  ~Reactor()
+  {
+    while (!sources.empty())
+      close(sources.back());
+    int fds[] = {tcp, udp, wake, epoll};
+    for (unsigned i = 0; i < sizeof(fds) / sizeof(fds[0]); ++i)
+      if (fds[i] >= 0)
+        ::close(fds[i]);
+  }
+
+  bool watch(int fd, void *ptr)
+  {
+    epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = ptr;
+    return epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &ev) == 0;
+  }
+
+  // Binds a socket of type to addr; port 0 in addr is replaced by the port
+  // the kernel chose, for the other reactors to share
+  bool listen(sockaddr_storage &addr, socklen_t len, int type, int &fd)
+  {
+    fd = socket(addr.ss_family, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+      return false;
+    int on = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0 ||
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0 ||
+        bind(fd, (sockaddr *)&addr, len) != 0 ||
+        (type == SOCK_STREAM && ::listen(fd, SOMAXCONN) != 0) ||
+        getsockname(fd, (sockaddr *)&addr, &len) != 0)
+      return false;
+    if (type == SOCK_DGRAM)
+    {
+      int size = _NavIC_INGEST_UDP_BUFFER;
+      setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+    return watch(fd, &fd);
+  }
+
+  void run()
+  {
+    epoll_event events[_NavIC_INGEST_EVENTS];
+    uint32_t lastSweep = navic_millis();
+    for (;;)
+    {
+      int n = epoll_wait(epoll, events, _NavIC_INGEST_EVENTS, idleMs ? _NavIC_INGEST_SWEEP_MS : -1);
+      if (n < 0 && errno != EINTR)
+        return;
+      uint32_t now = navic_millis();
+      for (int i = 0; i < n; ++i)
+      {
+        void *ptr = events[i].data.ptr;
+        if (ptr == &wake)
+          return;
+        else if (ptr == &tcp)
+          acceptAll(now);
+        else if (ptr == &udp)
+          receive(now);
+        else
+          read((Source *)ptr, now);
+      }
+      if (idleMs && now - lastSweep >= _NavIC_INGEST_SWEEP_MS)
+      {
+        sweep(now);
+        lastSweep = now;
+      }
+    }
+  }
+
+  Source *open(const sockaddr_storage &peer, int fd, uint32_t now)
+  {
+    Source *s = new Source;
+    s->info.id = idBase | ++serial;
+    s->info.udp = fd < 0;
+    s->info.peer = peer;
+    s->fd = fd;
+    s->index = sources.size();
+    s->lastMs = now;
+    s->callback = callback;
+    s->context = context;
+    s->listener.begin(s->navic, onFix, s, sentences);
+    sources.push_back(s);
+    add(accepted, 1);
+    return s;
+  }
+
+  void close(Source *s)
+  {
+    if (s->fd >= 0)
+      ::close(s->fd); // also leaves the epoll set
+    else
+      senders.erase(s->key);
+    sources[s->index] = sources.back();
+    sources[s->index]->index = s->index;
+    sources.pop_back();
+    delete s;
+    add(closed, 1);
+  }
+
+  void sweep(uint32_t now)
+  {
+    for (size_t i = sources.size(); i-- > 0;)
+      if (now - sources[i]->lastMs >= idleMs)
+        close(sources[i]);
+  }
+
+  void decode(Source *s, const char *buf, size_t len, uint32_t now)
+  {
+    uint32_t failedBefore = s->navic.failedChecksum();
+    add(passed, s->navic.encode(buf, len));
+    add(failed, s->navic.failedChecksum() - failedBefore);
+    add(bytes, len);
+    s->lastMs = now;
+  }
+
+  void acceptAll(uint32_t now)
+  {
+    for (;;)
+    {
+      sockaddr_storage peer;
+      socklen_t len = sizeof(peer);
+      int fd = accept4(tcp, (sockaddr *)&peer, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (fd < 0)
+        return;
+      if (sources.size() >= maxSources)
+      {
+        ::close(fd);
+        add(refused, 1);
+        continue;
+      }
+      Source *s = open(peer, fd, now);
+      if (!watch(fd, s))
+        close(s);
+    }
+  }
+
+  // One read per wakeup: epoll is level-triggered, so a busy connection
+  // comes round again without holding up the others
+  void read(Source *s, uint32_t now)
+  {
+    ssize_t n = ::read(s->fd, &buffer[0], _NavIC_INGEST_READ_SIZE);
+    if (n > 0)
+      decode(s, &buffer[0], n, now);
+    else if (n == 0 || (errno != EAGAIN && errno != EINTR))
+      close(s);
+  }
+
+  void receive(uint32_t now)
+  {
+    mmsghdr msgs[_NavIC_INGEST_UDP_BATCH];
+    iovec iov[_NavIC_INGEST_UDP_BATCH];
+    sockaddr_storage peers[_NavIC_INGEST_UDP_BATCH];
+    for (unsigned round = 0; round < _NavIC_INGEST_UDP_ROUNDS; ++round)
+    {
+      memset(msgs, 0, sizeof(msgs));
+      for (unsigned i = 0; i < _NavIC_INGEST_UDP_BATCH; ++i)
+      {
+        iov[i].iov_base = &buffer[i * _NavIC_INGEST_DATAGRAM];
+        iov[i].iov_len = _NavIC_INGEST_DATAGRAM;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &peers[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(peers[i]);
+      }
+      int n = recvmmsg(udp, msgs, _NavIC_INGEST_UDP_BATCH, MSG_DONTWAIT, NULL);
+      if (n <= 0)
+        return;
+      add(datagrams, n);
+      for (int i = 0; i < n; ++i)
+      {
+        Source *s = sender(peers[i], now);
+        if (s != NULL)
+          decode(s, (const char *)iov[i].iov_base, msgs[i].msg_len, now);
+      }
+      if (n < _NavIC_INGEST_UDP_BATCH)
+        return;
+    }
+  }
+
+  Source *sender(const sockaddr_storage &peer, uint32_t now)
+  {
+    std::string key = peerKey(peer);
+    std::unordered_map<std::string, Source *>::iterator it = senders.find(key);
+    if (it != senders.end())
+      return it->second;
+    if (sources.size() >= maxSources)
+    {
+      add(refused, 1);
+      return NULL;
+    }
+    Source *s = open(peer, -1, now);
+    s->key = key;
+    senders[key] = s;
+    return s;
+  }
+};
+
+navic_ingest_server::navic_ingest_server() : tcpBound(-1), udpBound(-1)
+{
+}
+
+bool navic_ingest_server::start(const NavIC_ingest_config &config, NavIC_ingest_callback callback, void *context,
+                                uint16_t sentences)
+{
+  stop();
+
+  sockaddr_storage addr;
+  socklen_t len;
+  memset(&addr, 0, sizeof(addr));
+  sockaddr_in *v4 = (sockaddr_in *)&addr;
+  sockaddr_in6 *v6 = (sockaddr_in6 *)&addr;
+  if (inet_pton(AF_INET, config.address, &v4->sin_addr) == 1)
+  {
+    v4->sin_family = AF_INET;
+    len = sizeof(*v4);
+  }
+  else if (inet_pton(AF_INET6, config.address, &v6->sin6_addr) == 1)
+  {
+    v6->sin6_family = AF_INET6;
+    len = sizeof(*v6);
+  }
+  else
+  {
+    errno = EINVAL;
+    return false;
+  }
+
+  unsigned threads = config.threads ? config.threads : std::thread::hardware_concurrency();
+  if (threads == 0)
+    threads = 1;
+  uint32_t perThread = (config.maxSources + threads - 1) / threads;
+
+  tcpBound = config.tcpPort;
+  udpBound = config.udpPort;
+  for (unsigned t = 0; t < threads; ++t)
+  {
+    Reactor *r = new Reactor(t, perThread, config.idleMs, callback, context, sentences);
+    reactors.push_back(r);
+    bool ok = r->epoll >= 0 && r->wake >= 0;
+    int *ports[] = {&tcpBound, &udpBound};
+    int types[] = {SOCK_STREAM, SOCK_DGRAM};
+    int *fds[] = {&r->tcp, &r->udp};
+    for (unsigned i = 0; ok && i < 2; ++i)
+    {
+      if (*ports[i] < 0)
+        continue;
+      // the first reactor may bind port 0; the rest join whatever it got
+      if (addr.ss_family == AF_INET)
+        v4->sin_port = htons(*ports[i]);
+      else
+        v6->sin6_port = htons(*ports[i]);
+      ok = r->listen(addr, len, types[i], *fds[i]);
+      *ports[i] = ntohs(addr.ss_family == AF_INET ? v4->sin_port : v6->sin6_port);
+    }
+    if (!ok)
+    {
+      int saved = errno;
+      stop();
+      errno = saved;
+      return false;
+    }
+  }
+
+  for (size_t t = 0; t < reactors.size(); ++t)
+    reactors[t]->thread = std::thread(&Reactor::run, reactors[t]);
+  return true;
+}
+
+void navic_ingest_server::stop()
+{
+  for (size_t t = 0; t < reactors.size(); ++t)
+  {
+    Reactor *r = reactors[t];
+    if (r->thread.joinable())
+    {
+      uint64_t one = 1;
+      ssize_t written = write(r->wake, &one, sizeof(one));
+      (void)written;
+      r->thread.join();
+    }
+    delete r;
+  }
+  reactors.clear();
+  tcpBound = udpBound = -1;
+}
+
+void navic_ingest_server::stats(NavIC_ingest_stats &out) const
+{
+  memset(&out, 0, sizeof(out));
+  for (size_t t = 0; t < reactors.size(); ++t)
+  {
+    const Reactor *r = reactors[t];
+    out.accepted += r->accepted.load(std::memory_order_relaxed);
+    out.refused += r->refused.load(std::memory_order_relaxed);
+    out.closed += r->closed.load(std::memory_order_relaxed);
+    out.bytes += r->bytes.load(std::memory_order_relaxed);
+    out.datagrams += r->datagrams.load(std::memory_order_relaxed);
+    out.passedChecksum += r->passed.load(std::memory_order_relaxed);
+    out.failedChecksum += r->failed.load(std::memory_order_relaxed);
+  }
+}
+
+#endif // _NavIC_HOST && __linux__
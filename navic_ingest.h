@@ -0,0 +1,102 @@
+/*
+navic_ingest - epoll server decoding NMEA streamed over TCP and UDP by many
+receivers at once (Linux hosts only)
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+#ifndef __navic_ingest_h
+#define __navic_ingest_h
+
+#include "navic_rmc_gga++.h"
+
+#if defined(_NavIC_HOST) && defined(__linux__)
+#include <sys/socket.h>
+#include <vector>
+
+#define _NavIC_INGEST_READ_SIZE 65536 // bytes per TCP read()
+#define _NavIC_INGEST_UDP_BATCH 32    // datagrams per recvmmsg()
+#define _NavIC_INGEST_IDLE_MS 60000
+
+struct NavIC_ingest_config
+{
+   const char *address; // numeric IPv4 or IPv6 address to listen on
+   int tcpPort;         // -1 for no TCP listener, 0 for any free port
+   int udpPort;         // likewise
+   unsigned threads;    // reactor threads, 0 = one per core
+   uint32_t maxSources; // connections and UDP senders beyond this are refused
+   uint32_t idleMs;     // sources silent this long are dropped, 0 = never
+
+   NavIC_ingest_config()
+       : address("0.0.0.0"), tcpPort(-1), udpPort(-1), threads(0), maxSources(65536), idleMs(_NavIC_INGEST_IDLE_MS)
+   {
+   }
+};
+
+// A TCP connection or UDP sender (address and port), each with its own
+// parser
+struct NavIC_ingest_source
+{
+   uint64_t id; // unique while the server runs
+   bool udp;
+   sockaddr_storage peer;
+};
+
+typedef void (*NavIC_ingest_callback)(const NavIC_ingest_source &source, const NavIC_fix &fix, void *context);
+
+struct NavIC_ingest_stats
+{
+   uint64_t accepted; // TCP connections and UDP senders
+   uint64_t refused;  // beyond maxSources
+   uint64_t closed;   // by the peer, on error or for idleness
+   uint64_t bytes;
+   uint64_t datagrams;
+   uint64_t passedChecksum;
+   uint64_t failedChecksum;
+};
+
+// A fixed set of reactor threads, each with its own epoll set, TCP
+// listener and UDP socket on the same ports (SO_REUSEPORT), so that the
+// kernel spreads connections and senders over the threads and no state is
+// shared between them.  Every source gets a navic_gn_rmc_gga that each
+// read is bulk-encoded into: up to _NavIC_INGEST_READ_SIZE bytes per TCP
+// read, _NavIC_INGEST_UDP_BATCH datagrams per recvmmsg().
+//
+// The callback gets the fixes the sentences mask selects (see
+// NavIC_LISTENER) on the reactor threads, so it must be thread safe; a
+// given source always reports from the same thread.
+class navic_ingest_server
+{
+public:
+   navic_ingest_server();
+   ~navic_ingest_server() { stop(); }
+
+   // Returns false, with errno set, if a socket could not be set up
+   bool start(const NavIC_ingest_config &config, NavIC_ingest_callback callback, void *context = 0,
+              uint16_t sentences = 0);
+   void stop();
+
+   // ports bound, useful after asking for port 0; -1 if not listening
+   int tcpPort() const { return tcpBound; }
+   int udpPort() const { return udpBound; }
+
+   void stats(NavIC_ingest_stats &out) const; // totals over all threads
+
+private:
+   struct Reactor;
+
+   navic_ingest_server(const navic_ingest_server &);
+   navic_ingest_server &operator=(const navic_ingest_server &);
+
+   std::vector<Reactor *> reactors;
+   int tcpBound, udpBound;
+};
+
+#endif // _NavIC_HOST && __linux__
+#endif // def(__navic_ingest_h)
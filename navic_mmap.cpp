@@ -0,0 +1,106 @@
+/*
+navic_mmap - memory-mapped capture file source (host only)
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_mmap.h"
+
+#ifdef _NavIC_HOST
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+navic_mapped_file::navic_mapped_file()
+    : fd(-1), fileSize(0), offset(0), window(0), mapping(NULL), mappingLen(0)
+{
+}
+
+navic_mapped_file::~navic_mapped_file()
+{
+  close();
+}
+
+bool navic_mapped_file::open(const char *path, size_t _window)
+{
+  close();
+
+  fd = ::open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    close();
+    return false;
+  }
+  fileSize = st.st_size;
+
+  // windows must start on page boundaries
+  size_t page = sysconf(_SC_PAGESIZE);
+  window = _window == 0 || _window >= fileSize ? fileSize : (_window + page - 1) / page * page;
+
+#ifdef POSIX_FADV_SEQUENTIAL
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+  return true;
+}
+
+void navic_mapped_file::close()
+{
+  unmap();
+  if (fd >= 0)
+    ::close(fd);
+  fd = -1;
+  fileSize = offset = 0;
+}
+
+void navic_mapped_file::unmap()
+{
+  if (mapping != NULL)
+    munmap(mapping, mappingLen);
+  mapping = NULL;
+  mappingLen = 0;
+}
+
+bool navic_mapped_file::next(const char *&data, size_t &len)
+{
+  unmap();
+  if (fd < 0 || offset >= fileSize)
+    return false;
+
+  size_t span = fileSize - offset < window ? fileSize - offset : window;
+  void *p = mmap(NULL, span, PROT_READ, MAP_PRIVATE, fd, offset);
+  if (p == MAP_FAILED)
+    return false;
+  madvise(p, span, MADV_SEQUENTIAL);
+  madvise(p, span, MADV_WILLNEED);
+
+  mapping = p;
+  mappingLen = span;
+  offset += span;
+  data = (const char *)p;
+  len = span;
+  return true;
+}
+
+size_t navic_mapped_file::encode(navic_gn_rmc_gga &navic)
+{
+  size_t validSentences = 0;
+  const char *data;
+  size_t len;
+  while (next(data, len))
+    validSentences += navic.encode(data, len);
+  return validSentences;
+}
+
+#endif // _NavIC_HOST
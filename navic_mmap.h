@@ -0,0 +1,59 @@
+/*
+navic_mmap - memory-mapped capture file source (host only)
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+#ifndef __navic_mmap_h
+#define __navic_mmap_h
+
+#include "navic_rmc_gga++.h"
+
+#ifdef _NavIC_HOST
+
+#define _NavIC_MMAP_WINDOW (256UL << 20)
+
+// Read-only view of a capture file, handed out as spans that point straight
+// into the page cache.  With a window of 0 the whole file is mapped at once;
+// otherwise next() walks it in windows of that many bytes (rounded to whole
+// pages), unmapping each one as the next is mapped, so files larger than RAM
+// stream through a bounded amount of address space.
+class navic_mapped_file
+{
+public:
+   navic_mapped_file();
+   ~navic_mapped_file();
+
+   bool open(const char *path, size_t window = _NavIC_MMAP_WINDOW);
+   void close();
+
+   uint64_t size() const { return fileSize; }
+
+   // maps the next span of the file; returns false at end of file or on error
+   bool next(const char *&data, size_t &len);
+
+   // streams the whole file through navic; returns sentences validated
+   size_t encode(navic_gn_rmc_gga &navic);
+
+private:
+   navic_mapped_file(const navic_mapped_file &);
+   navic_mapped_file &operator=(const navic_mapped_file &);
+
+   void unmap();
+
+   int fd;
+   uint64_t fileSize;
+   uint64_t offset;
+   size_t window;
+   void *mapping;
+   size_t mappingLen;
+};
+
+#endif // _NavIC_HOST
+#endif // def(__navic_mmap_h)
@@ -0,0 +1,433 @@
+/*
+navic_parser - RMC/GGA decoder specialised at compile time for the fix
+fields an application reads
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+#ifndef __navic_parser_h
+#define __navic_parser_h
+
+#include "navic_rmc_gga++.h"
+#include "navic_digits.h"
+#include "navic_scan.h"
+
+// Storage for one fix field, empty when the field is not decoded.  The
+// slots are base classes of NavIC_fields so that empty ones take no space.
+template <uint8_t Field, bool Present, class T>
+struct NavIC_slot
+{
+   T value;
+   NavIC_slot() : value() {}
+};
+
+template <uint8_t Field, class T>
+struct NavIC_slot<Field, false, T>
+{
+};
+
+struct NavIC_position
+{
+   RawDegrees lat, lng;
+};
+
+// Accessors that compile to nothing for a slot that is not there: writes
+// are dropped and reads leave the default
+template <uint8_t Field, class T>
+static inline void navic_store(NavIC_slot<Field, true, T> &slot, const T &value) { slot.value = value; }
+template <uint8_t Field, class T>
+static inline void navic_store(NavIC_slot<Field, false, T> &, const T &) {}
+template <uint8_t Field, class T>
+static inline void navic_load(const NavIC_slot<Field, true, T> &slot, T &value) { value = slot.value; }
+template <uint8_t Field, class T>
+static inline void navic_load(const NavIC_slot<Field, false, T> &, T &) {}
+template <uint8_t Field, class T>
+static inline void navic_copy(NavIC_slot<Field, true, T> &to, const NavIC_slot<Field, true, T> &from) { to.value = from.value; }
+template <uint8_t Field, class T>
+static inline void navic_copy(NavIC_slot<Field, false, T> &, const NavIC_slot<Field, false, T> &) {}
+template <uint8_t Field, class T>
+static inline T &navic_slot(NavIC_slot<Field, true, T> &slot) { return slot.value; }
+template <uint8_t Field, class T>
+static inline const T &navic_slot(const NavIC_slot<Field, true, T> &slot) { return slot.value; }
+// only ever called from code that a test on Fields removes
+template <uint8_t Field, class T>
+static inline T &navic_slot(NavIC_slot<Field, false, T> &)
+{
+  static T unused;
+  return unused;
+}
+
+#define _NavIC_HAS(fields, field) (((fields) & (field)) != 0)
+
+// The fields of NavIC_fix selected by Fields, a mask of NavIC_fix::LOCATION,
+// ::DATE, ...
+template <uint8_t Fields>
+struct NavIC_fields
+    : NavIC_slot<NavIC_fix::LOCATION, _NavIC_HAS(Fields, NavIC_fix::LOCATION), NavIC_position>,
+      NavIC_slot<NavIC_fix::DATE, _NavIC_HAS(Fields, NavIC_fix::DATE), uint32_t>,
+      NavIC_slot<NavIC_fix::TIME, _NavIC_HAS(Fields, NavIC_fix::TIME), uint32_t>,
+      NavIC_slot<NavIC_fix::SPEED, _NavIC_HAS(Fields, NavIC_fix::SPEED), int32_t>,
+      NavIC_slot<NavIC_fix::COURSE, _NavIC_HAS(Fields, NavIC_fix::COURSE), int32_t>,
+      NavIC_slot<NavIC_fix::ALTITUDE, _NavIC_HAS(Fields, NavIC_fix::ALTITUDE), int32_t>,
+      NavIC_slot<NavIC_fix::SATELLITES, _NavIC_HAS(Fields, NavIC_fix::SATELLITES), uint32_t>,
+      NavIC_slot<NavIC_fix::HDOP, _NavIC_HAS(Fields, NavIC_fix::HDOP), int32_t>
+{
+};
+
+// Decodes RMC/GGA into the fields in Fields only, e.g.
+//
+//   navic_parser<NavIC_fix::TIME | NavIC_fix::LOCATION> navic;
+//
+// Fields that are not selected take no RAM, their terms are skipped
+// without being copied, and a sentence type that carries none of them is
+// only checksummed.  Reading a field that is not selected is a compile
+// error.  There are no custom or fix listeners and no GSV/GSA tables; use
+// navic_gn_rmc_gga for those.
+template <uint8_t Fields>
+class navic_parser
+{
+public:
+   navic_parser();
+   bool encode(char c) { return encode(&c, 1) != 0; }
+   size_t encode(const char *buf, size_t len); // returns sentences validated
+
+   // Bitmasks of the fields that hold a value, and of those the last
+   // validated RMC/GGA sentence updated
+   uint8_t fields() const { return fix.fieldsMask; }
+   uint8_t committed() const { return fix.committedMask; }
+
+   const RawDegrees &lat() const { return location().lat; }
+   const RawDegrees &lng() const { return location().lng; }
+   uint32_t date() const { return get<NavIC_fix::DATE, uint32_t>(); }
+   uint32_t time() const { return get<NavIC_fix::TIME, uint32_t>(); }
+   int32_t speed() const { return get<NavIC_fix::SPEED, int32_t>(); }
+   int32_t course() const { return get<NavIC_fix::COURSE, int32_t>(); }
+   int32_t altitude() const { return get<NavIC_fix::ALTITUDE, int32_t>(); }
+   uint32_t satellites() const { return get<NavIC_fix::SATELLITES, uint32_t>(); }
+   int32_t hdop() const { return get<NavIC_fix::HDOP, int32_t>(); }
+
+   void snapshot(NavIC_fix &out) const; // fields not selected are left at 0
+
+   uint32_t charsProcessed() const { return encodedCharCount; }
+   uint32_t failedChecksum() const { return failedChecksumCount; }
+   uint32_t passedChecksum() const { return passedChecksumCount; }
+
+private:
+   enum
+   {
+      CHECKSUM_TERM = 0x01,
+      HAS_FIX = 0x02
+   };
+
+   // The terms decoded per sentence type, bit n for term n
+   enum
+   {
+      RMC_TERMS = (_NavIC_HAS(Fields, NavIC_fix::TIME) ? 0x002 : 0) |
+                  (_NavIC_HAS(Fields, NavIC_fix::LOCATION | NavIC_fix::SPEED | NavIC_fix::COURSE) ? 0x004 : 0) |
+                  (_NavIC_HAS(Fields, NavIC_fix::LOCATION) ? 0x078 : 0) |
+                  (_NavIC_HAS(Fields, NavIC_fix::SPEED) ? 0x080 : 0) |
+                  (_NavIC_HAS(Fields, NavIC_fix::COURSE) ? 0x100 : 0) |
+                  (_NavIC_HAS(Fields, NavIC_fix::DATE) ? 0x200 : 0),
+      GGA_TERMS = (_NavIC_HAS(Fields, NavIC_fix::TIME) ? 0x002 : 0) |
+                  (_NavIC_HAS(Fields, NavIC_fix::LOCATION) ? 0x03C : 0) |
+                  (_NavIC_HAS(Fields, NavIC_fix::LOCATION | NavIC_fix::ALTITUDE) ? 0x040 : 0) |
+                  (_NavIC_HAS(Fields, NavIC_fix::SATELLITES) ? 0x080 : 0) |
+                  (_NavIC_HAS(Fields, NavIC_fix::HDOP) ? 0x100 : 0) |
+                  (_NavIC_HAS(Fields, NavIC_fix::ALTITUDE) ? 0x200 : 0)
+   };
+
+   struct Fix : NavIC_fields<Fields>
+   {
+      uint8_t fieldsMask, committedMask, sentence, talker;
+      Fix() : fieldsMask(0), committedMask(0), sentence(navic_gn_rmc_gga::NAVIC_SENTENCE_OTHER), talker(navic_gn_rmc_gga::NAVIC_TALKER_OTHER) {}
+   };
+
+   template <uint8_t Field, class T>
+   T get() const
+   {
+      static_assert(_NavIC_HAS(Fields, Field), "navic_parser: field is not among Fields");
+      T value;
+      navic_load<Field>(fix, value);
+      return value;
+   }
+   const NavIC_position &location() const
+   {
+      static_assert(_NavIC_HAS(Fields, NavIC_fix::LOCATION), "navic_parser: NavIC_fix::LOCATION is not among Fields");
+      return navic_slot<NavIC_fix::LOCATION>(fix);
+   }
+
+   // parsing state
+   uint8_t parity;
+   uint8_t flags;
+   uint8_t sentenceType;
+   uint8_t talker;
+   uint8_t termNumber;
+   uint8_t termOffset;
+   char term[_NavIC_MAX_FIELD_SIZE + _NavIC_TERM_PADDING];
+   NavIC_fields<Fields> pending;
+
+   // results and statistics
+   Fix fix;
+   uint32_t encodedCharCount;
+   uint32_t passedChecksumCount;
+   uint32_t failedChecksumCount;
+
+   uint32_t decodedTerms() const
+   {
+      return sentenceType == navic_gn_rmc_gga::NAVIC_SENTENCE_RMC ? RMC_TERMS : sentenceType == navic_gn_rmc_gga::NAVIC_SENTENCE_GGA ? GGA_TERMS : 0;
+   }
+   bool endOfTerm();
+   struct FixDecoder;
+   void commit();
+};
+
+template <uint8_t Fields>
+navic_parser<Fields>::navic_parser()
+    : parity(0), flags(0), sentenceType(navic_gn_rmc_gga::NAVIC_SENTENCE_OTHER), talker(navic_gn_rmc_gga::NAVIC_TALKER_OTHER),
+      termNumber(0), termOffset(0), encodedCharCount(0), passedChecksumCount(0), failedChecksumCount(0)
+{
+  memset(term, 0, sizeof(term));
+}
+
+// Same state machine as navic_stream_pool::encode(), except that only the
+// terms Fields needs are copied out of buf
+template <uint8_t Fields>
+size_t navic_parser<Fields>::encode(const char *buf, size_t len)
+{
+  size_t validSentences = 0;
+  const char *end = buf + len;
+  encodedCharCount += len;
+
+  while (buf < end)
+  {
+    bool checksumTerm = flags & CHECKSUM_TERM;
+    bool skipping = !checksumTerm && sentenceType == navic_gn_rmc_gga::NAVIC_SENTENCE_OTHER && termNumber > 0;
+    bool copying = checksumTerm || termNumber == 0 || (termNumber < 32 && (decodedTerms() >> termNumber & 1));
+    size_t run;
+    if (checksumTerm)
+      run = navic_scan<true, false>(buf, end - buf, parity);
+    else if (skipping)
+      run = navic_scan<false, true>(buf, end - buf, parity);
+    else
+      run = navic_scan<true, true>(buf, end - buf, parity);
+
+    if (copying)
+    {
+      size_t room = _NavIC_MAX_FIELD_SIZE - 1 - termOffset;
+      size_t n = run < room ? run : room;
+      memcpy(term + termOffset, buf, n);
+      termOffset += n;
+    }
+    buf += run;
+
+    if (buf == end)
+      break;
+
+    char c = *buf++;
+    if (c == '$')
+    {
+      parity = 0;
+      flags = 0;
+      termOffset = 0;
+      termNumber = 0;
+      sentenceType = navic_gn_rmc_gga::NAVIC_SENTENCE_OTHER;
+      continue;
+    }
+
+    if (c == ',')
+      parity ^= (uint8_t)c;
+    term[termOffset] = 0;
+    if (endOfTerm())
+      ++validSentences;
+    if (termNumber < 255)
+      ++termNumber;
+    termOffset = 0;
+    flags = c == '*' ? flags | CHECKSUM_TERM : flags & ~CHECKSUM_TERM;
+  }
+
+  return validSentences;
+}
+
+// The RMC/GGA fields, as navic_fix_term() hands them over; the compiler
+// drops every field not in Fields
+template <uint8_t Fields>
+struct navic_parser<Fields>::FixDecoder
+{
+   const char *t;
+   NavIC_fields<Fields> &pending;
+   uint8_t &flags;
+
+   char head() const { return t[0]; }
+   void time()
+   {
+      if (_NavIC_HAS(Fields, NavIC_fix::TIME))
+         navic_store<NavIC_fix::TIME>(pending, (uint32_t)navic_parse_decimal<_NavIC_TERM_PADDED>(t, 2));
+   }
+   void hasFix(bool fix) { flags = fix ? flags | HAS_FIX : flags & ~HAS_FIX; }
+   void latitude()
+   {
+      if (_NavIC_HAS(Fields, NavIC_fix::LOCATION))
+         navic_parse_degrees<_NavIC_TERM_PADDED>(t, navic_slot<NavIC_fix::LOCATION>(pending).lat);
+   }
+   void south(bool south)
+   {
+      if (_NavIC_HAS(Fields, NavIC_fix::LOCATION))
+         navic_slot<NavIC_fix::LOCATION>(pending).lat.negative = south;
+   }
+   void longitude()
+   {
+      if (_NavIC_HAS(Fields, NavIC_fix::LOCATION))
+         navic_parse_degrees<_NavIC_TERM_PADDED>(t, navic_slot<NavIC_fix::LOCATION>(pending).lng);
+   }
+   void west(bool west)
+   {
+      if (_NavIC_HAS(Fields, NavIC_fix::LOCATION))
+         navic_slot<NavIC_fix::LOCATION>(pending).lng.negative = west;
+   }
+   void speed()
+   {
+      if (_NavIC_HAS(Fields, NavIC_fix::SPEED))
+         navic_store<NavIC_fix::SPEED>(pending, navic_parse_decimal<_NavIC_TERM_PADDED>(t, 2));
+   }
+   void course()
+   {
+      if (_NavIC_HAS(Fields, NavIC_fix::COURSE))
+         navic_store<NavIC_fix::COURSE>(pending, navic_parse_decimal<_NavIC_TERM_PADDED>(t, 2));
+   }
+   void date()
+   {
+      if (_NavIC_HAS(Fields, NavIC_fix::DATE))
+         navic_store<NavIC_fix::DATE>(pending, navic_parse_uint<_NavIC_TERM_PADDED>(t));
+   }
+   void satellites()
+   {
+      if (_NavIC_HAS(Fields, NavIC_fix::SATELLITES))
+         navic_store<NavIC_fix::SATELLITES>(pending, navic_parse_uint<_NavIC_TERM_PADDED>(t));
+   }
+   void hdop()
+   {
+      if (_NavIC_HAS(Fields, NavIC_fix::HDOP))
+         navic_store<NavIC_fix::HDOP>(pending, navic_parse_decimal<_NavIC_TERM_PADDED>(t, 2));
+   }
+   void altitude()
+   {
+      if (_NavIC_HAS(Fields, NavIC_fix::ALTITUDE))
+         navic_store<NavIC_fix::ALTITUDE>(pending, navic_parse_decimal<_NavIC_TERM_PADDED>(t, 2));
+   }
+};
+
+// Processes a just-completed term
+// Returns true if the sentence has just passed its checksum test
+template <uint8_t Fields>
+bool navic_parser<Fields>::endOfTerm()
+{
+  if (flags & CHECKSUM_TERM)
+  {
+    byte checksum = 16 * navic_gn_rmc_gga::fromHex(term[0]) + navic_gn_rmc_gga::fromHex(term[0] ? term[1] : 0);
+    if (checksum != parity)
+    {
+      ++failedChecksumCount;
+      return false;
+    }
+    ++passedChecksumCount;
+    commit();
+    return true;
+  }
+
+  if (termNumber == 0)
+  {
+    sentenceType = navic_gn_rmc_gga::sentenceTypeOf(navic_gn_rmc_gga::sentenceTag(term), talker);
+    // a sentence that carries none of Fields is only checksummed
+    if (decodedTerms() == 0)
+      sentenceType = navic_gn_rmc_gga::NAVIC_SENTENCE_OTHER;
+    return false;
+  }
+
+  const char *t = term;
+  if (termNumber >= 32 || !(decodedTerms() >> termNumber & 1) || !t[0])
+    return false;
+
+  FixDecoder decoder = {t, pending, flags};
+  navic_fix_term(sentenceType, termNumber, decoder);
+
+  return false;
+}
+
+// Commits as navic_gn_rmc_gga does, restricted to Fields
+template <uint8_t Fields>
+void navic_parser<Fields>::commit()
+{
+  const NavIC_fields<Fields> &next = pending;
+  NavIC_fields<Fields> &to = fix;
+  bool hasFix = flags & HAS_FIX;
+  uint8_t committed;
+
+  switch (sentenceType)
+  {
+  case navic_gn_rmc_gga::NAVIC_SENTENCE_RMC:
+    committed = NavIC_fix::DATE | NavIC_fix::TIME;
+    if (hasFix)
+      committed |= NavIC_fix::LOCATION | NavIC_fix::SPEED | NavIC_fix::COURSE;
+    break;
+  case navic_gn_rmc_gga::NAVIC_SENTENCE_GGA:
+    committed = NavIC_fix::TIME | NavIC_fix::SATELLITES | NavIC_fix::HDOP;
+    if (hasFix)
+      committed |= NavIC_fix::LOCATION | NavIC_fix::ALTITUDE;
+    break;
+  default:
+    committed = 0;
+    break;
+  }
+  committed &= Fields;
+
+  if (committed & NavIC_fix::LOCATION)
+    navic_copy<NavIC_fix::LOCATION>(to, next);
+  if (committed & NavIC_fix::DATE)
+    navic_copy<NavIC_fix::DATE>(to, next);
+  if (committed & NavIC_fix::TIME)
+    navic_copy<NavIC_fix::TIME>(to, next);
+  if (committed & NavIC_fix::SPEED)
+    navic_copy<NavIC_fix::SPEED>(to, next);
+  if (committed & NavIC_fix::COURSE)
+    navic_copy<NavIC_fix::COURSE>(to, next);
+  if (committed & NavIC_fix::ALTITUDE)
+    navic_copy<NavIC_fix::ALTITUDE>(to, next);
+  if (committed & NavIC_fix::SATELLITES)
+    navic_copy<NavIC_fix::SATELLITES>(to, next);
+  if (committed & NavIC_fix::HDOP)
+    navic_copy<NavIC_fix::HDOP>(to, next);
+
+  fix.committedMask = committed;
+  fix.fieldsMask |= committed;
+  fix.sentence = sentenceType;
+  fix.talker = talker;
+}
+
+template <uint8_t Fields>
+void navic_parser<Fields>::snapshot(NavIC_fix &out) const
+{
+  out = NavIC_fix();
+  NavIC_position position;
+  navic_load<NavIC_fix::LOCATION>(fix, position);
+  out.lat = position.lat;
+  out.lng = position.lng;
+  navic_load<NavIC_fix::DATE>(fix, out.date);
+  navic_load<NavIC_fix::TIME>(fix, out.time);
+  navic_load<NavIC_fix::SPEED>(fix, out.speed);
+  navic_load<NavIC_fix::COURSE>(fix, out.course);
+  navic_load<NavIC_fix::ALTITUDE>(fix, out.altitude);
+  navic_load<NavIC_fix::SATELLITES>(fix, out.satellites);
+  navic_load<NavIC_fix::HDOP>(fix, out.hdop);
+  out.sentence = fix.sentence;
+  out.talker = fix.talker;
+  out.fields = fix.fieldsMask;
+  out.committed = fix.committedMask;
+}
+
+#endif // def(__navic_parser_h)
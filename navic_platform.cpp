@@ -0,0 +1,73 @@
+/*
+navic_platform - platform abstraction for the NavIC NMEA parser
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_platform.h"
+
+#ifdef _NavIC_HOST
+#include <time.h>
+
+static uint32_t defaultClock()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+static uint32_t defaultCycles()
+{
+  return (uint32_t)__builtin_ia32_rdtsc();
+}
+#else
+static uint32_t defaultCycles()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+#endif
+#else
+static uint32_t defaultClock()
+{
+  return millis();
+}
+
+static uint32_t defaultCycles()
+{
+  return micros();
+}
+#endif
+
+static NavIC_clock_fn clockFn = defaultClock;
+
+void navic_set_clock(NavIC_clock_fn fn)
+{
+  clockFn = fn ? fn : defaultClock;
+}
+
+uint32_t navic_millis()
+{
+  return clockFn();
+}
+
+static NavIC_clock_fn cyclesFn = defaultCycles;
+
+void navic_set_cycle_counter(NavIC_clock_fn fn)
+{
+  cyclesFn = fn ? fn : defaultCycles;
+}
+
+uint32_t navic_cycles()
+{
+  return cyclesFn();
+}
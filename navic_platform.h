@@ -0,0 +1,78 @@
+/*
+navic_platform - platform abstraction for the NavIC NMEA parser
+Lets the decoder build both as an Arduino library and as a plain
+host-side library (Linux servers, tools, benchmarks).
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+#ifndef __navic_platform_h
+#define __navic_platform_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#elif defined(ARDUINO)
+#include "WProgram.h"
+#else
+#define _NavIC_HOST 1
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+typedef uint8_t byte;
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+#ifndef TWO_PI
+#define TWO_PI 6.283185307179586476925286766559
+#endif
+#ifndef DEG_TO_RAD
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#endif
+#ifndef RAD_TO_DEG
+#define RAD_TO_DEG 57.295779513082320876798154814105
+#endif
+#ifndef radians
+#define radians(deg) ((deg) * DEG_TO_RAD)
+#endif
+#ifndef degrees
+#define degrees(rad) ((rad) * RAD_TO_DEG)
+#endif
+#ifndef sq
+#define sq(x) ((x) * (x))
+#endif
+#endif // ARDUINO
+
+// Monotonic millisecond clock used for age() and commit timestamps.
+// Defaults to millis() on Arduino and CLOCK_MONOTONIC on the host;
+// pass NULL to navic_set_clock() to restore the default.
+typedef uint32_t (*NavIC_clock_fn)();
+
+void navic_set_clock(NavIC_clock_fn fn);
+uint32_t navic_millis();
+
+// Free-running counter for the parser's stage timings (_NavIC_STATS): the
+// time stamp counter on x86 hosts, CLOCK_MONOTONIC nanoseconds on other
+// hosts and micros() on Arduino.  Only differences are used, so it may
+// wrap; pass NULL to navic_set_cycle_counter() to restore the default.
+void navic_set_cycle_counter(NavIC_clock_fn fn);
+uint32_t navic_cycles();
+
+// Word-at-a-time scanning and digit conversion are used where 64-bit loads
+// are cheap and the byte order is known; everything else takes plain byte
+// loops.
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ && __SIZEOF_POINTER__ >= 4
+#define _NavIC_SWAR 1
+#if __SIZEOF_POINTER__ >= 8
+#define _NavIC_SWAR_DIGITS 1 // needs fast 64-bit multiplies
+#endif
+#endif
+
+#endif // def(__navic_platform_h)
@@ -0,0 +1,241 @@
+/*
+navic_pool - many-receiver RMC/GGA decoding from a single thread
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_pool.h"
+#include "navic_digits.h"
+#include "navic_scan.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+// The RMC/GGA fields, as navic_fix_term() hands them over
+struct navic_stream_pool::FixDecoder
+{
+  const char *t;
+  NavIC_fix &next;
+  uint8_t &streamFlags;
+
+  char head() const { return t[0]; }
+  void time() { next.time = (uint32_t)navic_parse_decimal<_NavIC_TERM_PADDED>(t, 2); }
+  void hasFix(bool fix) { streamFlags = fix ? streamFlags | HAS_FIX : streamFlags & ~HAS_FIX; }
+  void latitude() { navic_parse_degrees<_NavIC_TERM_PADDED>(t, next.lat); }
+  void south(bool south) { next.lat.negative = south; }
+  void longitude() { navic_parse_degrees<_NavIC_TERM_PADDED>(t, next.lng); }
+  void west(bool west) { next.lng.negative = west; }
+  void speed() { next.speed = navic_parse_decimal<_NavIC_TERM_PADDED>(t, 2); }
+  void course() { next.course = navic_parse_decimal<_NavIC_TERM_PADDED>(t, 2); }
+  void date() { next.date = navic_parse_uint<_NavIC_TERM_PADDED>(t); }
+  void satellites() { next.satellites = navic_parse_uint<_NavIC_TERM_PADDED>(t); }
+  void hdop() { next.hdop = navic_parse_decimal<_NavIC_TERM_PADDED>(t, 2); }
+  void altitude() { next.altitude = navic_parse_decimal<_NavIC_TERM_PADDED>(t, 2); }
+};
+
+navic_stream_pool::navic_stream_pool(uint32_t capacity)
+    : count(capacity)
+{
+  parity = new uint8_t[count];
+  flags = new uint8_t[count];
+  sentenceType = new uint8_t[count];
+  talker = new uint8_t[count];
+  termNumber = new uint8_t[count];
+  termOffset = new uint8_t[count];
+  term = new char[count + 1][_NavIC_MAX_FIELD_SIZE]; // the spare row pads the last term for navic_digits.h
+  pending = new NavIC_fix[count];
+  fixes = new NavIC_fix[count];
+  encodedCharCount = new uint32_t[count];
+  passedChecksumCount = new uint32_t[count];
+  failedChecksumCount = new uint32_t[count];
+
+  for (uint32_t i = 0; i < count; ++i)
+    reset(i);
+}
+
+navic_stream_pool::~navic_stream_pool()
+{
+  delete[] parity;
+  delete[] flags;
+  delete[] sentenceType;
+  delete[] talker;
+  delete[] termNumber;
+  delete[] termOffset;
+  delete[] term;
+  delete[] pending;
+  delete[] fixes;
+  delete[] encodedCharCount;
+  delete[] passedChecksumCount;
+  delete[] failedChecksumCount;
+}
+
+void navic_stream_pool::reset(uint32_t stream)
+{
+  parity[stream] = 0;
+  flags[stream] = 0;
+  sentenceType[stream] = navic_gn_rmc_gga::NAVIC_SENTENCE_OTHER;
+  talker[stream] = navic_gn_rmc_gga::NAVIC_TALKER_OTHER;
+  termNumber[stream] = 0;
+  termOffset[stream] = 0;
+  term[stream][0] = '\0';
+  pending[stream] = NavIC_fix();
+  fixes[stream] = NavIC_fix();
+  encodedCharCount[stream] = 0;
+  passedChecksumCount[stream] = 0;
+  failedChecksumCount[stream] = 0;
+}
+
+// Same state machine as navic_gn_rmc_gga::encode(const char *, size_t), with
+// the hot per-stream state held in locals for the length of the buffer
+size_t navic_stream_pool::encode(uint32_t stream, const char *buf, size_t len)
+{
+  size_t validSentences = 0;
+  const char *end = buf + len;
+  uint8_t streamParity = parity[stream];
+  uint8_t streamFlags = flags[stream];
+  uint8_t offset = termOffset[stream];
+  char *streamTerm = term[stream];
+  encodedCharCount[stream] += len;
+
+  while (buf < end)
+  {
+    bool checksumTerm = streamFlags & CHECKSUM_TERM;
+    bool skipping = !checksumTerm && sentenceType[stream] == navic_gn_rmc_gga::NAVIC_SENTENCE_OTHER && termNumber[stream] > 0;
+    size_t run;
+    if (checksumTerm)
+      run = navic_scan<true, false>(buf, end - buf, streamParity);
+    else if (skipping)
+      run = navic_scan<false, true>(buf, end - buf, streamParity);
+    else
+      run = navic_scan<true, true>(buf, end - buf, streamParity);
+
+    if (!skipping)
+    {
+      size_t room = _NavIC_MAX_FIELD_SIZE - 1 - offset;
+      size_t n = run < room ? run : room;
+      memcpy(streamTerm + offset, buf, n);
+      offset += n;
+    }
+    buf += run;
+
+    if (buf == end)
+      break;
+
+    char c = *buf++;
+    if (c == '$')
+    {
+      streamParity = 0;
+      streamFlags = 0;
+      offset = 0;
+      termNumber[stream] = 0;
+      sentenceType[stream] = navic_gn_rmc_gga::NAVIC_SENTENCE_OTHER;
+      continue;
+    }
+
+    if (c == ',')
+      streamParity ^= (uint8_t)c;
+    streamTerm[offset] = 0;
+    parity[stream] = streamParity;
+    if (endOfTerm(stream, streamFlags))
+      ++validSentences;
+    if (termNumber[stream] < 255)
+      ++termNumber[stream];
+    offset = 0;
+    streamFlags = c == '*' ? streamFlags | CHECKSUM_TERM : streamFlags & ~CHECKSUM_TERM;
+  }
+
+  parity[stream] = streamParity;
+  flags[stream] = streamFlags;
+  termOffset[stream] = offset;
+  return validSentences;
+}
+
+// Processes a just-completed term of stream
+// Returns true if the sentence has just passed its checksum test
+bool navic_stream_pool::endOfTerm(uint32_t stream, uint8_t &streamFlags)
+{
+  const char *t = term[stream];
+
+  if (streamFlags & CHECKSUM_TERM)
+  {
+    // an empty term leaves t[1] over from the previous one; read it as the
+    // parser's zeroed termHead does
+    byte checksum = 16 * navic_gn_rmc_gga::fromHex(t[0]) + navic_gn_rmc_gga::fromHex(t[0] ? t[1] : 0);
+    if (checksum != parity[stream])
+    {
+      ++failedChecksumCount[stream];
+      return false;
+    }
+    ++passedChecksumCount[stream];
+    commit(stream, streamFlags);
+    return true;
+  }
+
+  if (termNumber[stream] == 0)
+  {
+    uint8_t type = navic_gn_rmc_gga::sentenceTypeOf(navic_gn_rmc_gga::sentenceTag(t), talker[stream]);
+    // only RMC/GGA are decoded per stream; everything else is skipped
+    if (type != navic_gn_rmc_gga::NAVIC_SENTENCE_RMC && type != navic_gn_rmc_gga::NAVIC_SENTENCE_GGA)
+      type = navic_gn_rmc_gga::NAVIC_SENTENCE_OTHER;
+    sentenceType[stream] = type;
+    return false;
+  }
+
+  if (sentenceType[stream] == navic_gn_rmc_gga::NAVIC_SENTENCE_OTHER || !t[0])
+    return false;
+
+  FixDecoder decoder = {t, pending[stream], streamFlags};
+  navic_fix_term(sentenceType[stream], termNumber[stream], decoder);
+
+  return false;
+}
+
+void navic_stream_pool::commit(uint32_t stream, uint8_t streamFlags)
+{
+  const NavIC_fix &next = pending[stream];
+  NavIC_fix &fix = fixes[stream];
+  bool hasFix = streamFlags & HAS_FIX;
+
+  switch (sentenceType[stream])
+  {
+  case navic_gn_rmc_gga::NAVIC_SENTENCE_RMC:
+    fix.date = next.date;
+    fix.time = next.time;
+    fix.committed = NavIC_fix::DATE | NavIC_fix::TIME;
+    if (hasFix)
+    {
+      fix.lat = next.lat;
+      fix.lng = next.lng;
+      fix.speed = next.speed;
+      fix.course = next.course;
+      fix.committed |= NavIC_fix::LOCATION | NavIC_fix::SPEED | NavIC_fix::COURSE;
+    }
+    break;
+  case navic_gn_rmc_gga::NAVIC_SENTENCE_GGA:
+    fix.time = next.time;
+    fix.committed = NavIC_fix::TIME | NavIC_fix::SATELLITES | NavIC_fix::HDOP;
+    if (hasFix)
+    {
+      fix.lat = next.lat;
+      fix.lng = next.lng;
+      fix.altitude = next.altitude;
+      fix.committed |= NavIC_fix::LOCATION | NavIC_fix::ALTITUDE;
+    }
+    fix.satellites = next.satellites;
+    fix.hdop = next.hdop;
+    break;
+  default:
+    fix.committed = 0;
+    break;
+  }
+  fix.fields |= fix.committed;
+  fix.sentence = sentenceType[stream];
+  fix.talker = talker[stream];
+}
@@ -0,0 +1,72 @@
+/*
+navic_pool - many-receiver RMC/GGA decoding from a single thread
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+#ifndef __navic_pool_h
+#define __navic_pool_h
+
+#include "navic_rmc_gga++.h"
+
+// Decodes RMC/GGA for a fixed number of streams.  The per-stream parse state
+// is laid out as parallel arrays indexed by stream id, so the state that is
+// touched on every byte stays dense no matter how many receivers are open.
+// Storage is allocated once, in the constructor.
+class navic_stream_pool
+{
+public:
+   navic_stream_pool(uint32_t capacity);
+   ~navic_stream_pool();
+
+   uint32_t capacity() const { return count; }
+   void reset(uint32_t stream); // forget parse state and fix of one stream
+
+   // process a buffer received on stream; returns sentences validated
+   size_t encode(uint32_t stream, const char *buf, size_t len);
+
+   const NavIC_fix &fix(uint32_t stream) const { return fixes[stream]; }
+   uint32_t charsProcessed(uint32_t stream) const { return encodedCharCount[stream]; }
+   uint32_t passedChecksum(uint32_t stream) const { return passedChecksumCount[stream]; }
+   uint32_t failedChecksum(uint32_t stream) const { return failedChecksumCount[stream]; }
+
+private:
+   navic_stream_pool(const navic_stream_pool &);
+   navic_stream_pool &operator=(const navic_stream_pool &);
+
+   enum
+   {
+      CHECKSUM_TERM = 0x01,
+      HAS_FIX = 0x02
+   };
+
+   uint32_t count;
+
+   // parsing state, one entry per stream
+   uint8_t *parity;
+   uint8_t *flags;
+   uint8_t *sentenceType;
+   uint8_t *talker;
+   uint8_t *termNumber;
+   uint8_t *termOffset;
+   char (*term)[_NavIC_MAX_FIELD_SIZE];
+   NavIC_fix *pending;
+
+   // results and statistics, one entry per stream
+   NavIC_fix *fixes;
+   uint32_t *encodedCharCount;
+   uint32_t *passedChecksumCount;
+   uint32_t *failedChecksumCount;
+
+   bool endOfTerm(uint32_t stream, uint8_t &streamFlags);
+   struct FixDecoder;
+   void commit(uint32_t stream, uint8_t streamFlags);
+};
+
+#endif // def(__navic_pool_h)
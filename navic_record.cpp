@@ -0,0 +1,309 @@
+/*
+navic_record - compact binary storage for committed fixes
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_record.h"
+
+#include <string.h>
+
+static void put16(uint8_t *p, uint16_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+  put16(p, (uint16_t)v);
+  put16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+  return get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+// Record layout (offsets in bytes):
+//  0 lat.deg   2 lat.billionths   6 lng.deg   8 lng.billionths
+// 12 date     16 time            20 speed    24 course
+// 28 altitude 32 hdop            36 satellites (clamped to 8 bits)
+// 37 sign bits (1 = lat south, 2 = lng west)
+// 38 sentence (low nibble) and talker (high nibble)  39 fields
+// committed is not stored, and unpacks as 0
+void navic_record_pack(const NavIC_fix &fix, uint8_t *record)
+{
+  put16(record + 0, fix.lat.deg);
+  put32(record + 2, fix.lat.billionths);
+  put16(record + 6, fix.lng.deg);
+  put32(record + 8, fix.lng.billionths);
+  put32(record + 12, fix.date);
+  put32(record + 16, fix.time);
+  put32(record + 20, (uint32_t)fix.speed);
+  put32(record + 24, (uint32_t)fix.course);
+  put32(record + 28, (uint32_t)fix.altitude);
+  put32(record + 32, (uint32_t)fix.hdop);
+  record[36] = fix.satellites > 255 ? 255 : (uint8_t)fix.satellites;
+  record[37] = (fix.lat.negative ? 1 : 0) | (fix.lng.negative ? 2 : 0);
+  record[38] = (fix.sentence & 0x0f) | (uint8_t)(fix.talker << 4);
+  record[39] = fix.fields;
+}
+
+void navic_record_unpack(const uint8_t *record, NavIC_fix &fix)
+{
+  fix.lat.deg = get16(record + 0);
+  fix.lat.billionths = get32(record + 2);
+  fix.lng.deg = get16(record + 6);
+  fix.lng.billionths = get32(record + 8);
+  fix.date = get32(record + 12);
+  fix.time = get32(record + 16);
+  fix.speed = (int32_t)get32(record + 20);
+  fix.course = (int32_t)get32(record + 24);
+  fix.altitude = (int32_t)get32(record + 28);
+  fix.hdop = (int32_t)get32(record + 32);
+  fix.satellites = record[36];
+  fix.lat.negative = record[37] & 1;
+  fix.lng.negative = (record[37] & 2) != 0;
+  fix.sentence = record[38] & 0x0f;
+  fix.talker = record[38] >> 4;
+  fix.fields = record[39];
+  fix.committed = 0;
+}
+
+#ifdef _NavIC_HOST
+#include "navic_mmap.h"
+
+#define _NavIC_BLOCK_HEADER 12
+#define _NavIC_BLOCK_COLUMNS 13
+
+// deg, billionths and sign in one integer, so that neighbouring points
+// of a track differ by a small delta and nothing is lost
+static int64_t packDegrees(const RawDegrees &deg)
+{
+  return ((int64_t)deg.deg << 33) | ((int64_t)deg.billionths << 1) | (deg.negative ? 1 : 0);
+}
+
+static void unpackDegrees(int64_t v, RawDegrees &deg)
+{
+  deg.negative = v & 1;
+  deg.billionths = (uint32_t)(v >> 1);
+  deg.deg = (uint16_t)(v >> 33);
+}
+
+static int64_t getColumn(const NavIC_fix &fix, int column)
+{
+  switch (column)
+  {
+  case 0: return packDegrees(fix.lat);
+  case 1: return packDegrees(fix.lng);
+  case 2: return fix.date;
+  case 3: return fix.time;
+  case 4: return fix.speed;
+  case 5: return fix.course;
+  case 6: return fix.altitude;
+  case 7: return fix.satellites;
+  case 8: return fix.hdop;
+  case 9: return fix.sentence;
+  case 10: return fix.fields;
+  case 11: return fix.committed;
+  default: return fix.talker;
+  }
+}
+
+static void setColumn(NavIC_fix &fix, int column, int64_t v)
+{
+  switch (column)
+  {
+  case 0: unpackDegrees(v, fix.lat); break;
+  case 1: unpackDegrees(v, fix.lng); break;
+  case 2: fix.date = (uint32_t)v; break;
+  case 3: fix.time = (uint32_t)v; break;
+  case 4: fix.speed = (int32_t)v; break;
+  case 5: fix.course = (int32_t)v; break;
+  case 6: fix.altitude = (int32_t)v; break;
+  case 7: fix.satellites = (uint32_t)v; break;
+  case 8: fix.hdop = (int32_t)v; break;
+  case 9: fix.sentence = (uint8_t)v; break;
+  case 10: fix.fields = (uint8_t)v; break;
+  case 11: fix.committed = (uint8_t)v; break;
+  default: fix.talker = (uint8_t)v; break;
+  }
+}
+
+static void putVarint(std::vector<uint8_t> &out, int64_t delta)
+{
+  uint64_t v = ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);
+  while (v >= 0x80)
+  {
+    out.push_back((uint8_t)(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back((uint8_t)v);
+}
+
+static bool getVarint(const uint8_t *&p, const uint8_t *end, int64_t &delta)
+{
+  uint64_t v = 0;
+  for (unsigned shift = 0; p < end && shift < 64; shift += 7)
+  {
+    uint8_t b = *p++;
+    v |= (uint64_t)(b & 0x7f) << shift;
+    if (!(b & 0x80))
+    {
+      delta = (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+      return true;
+    }
+  }
+  return false;
+}
+
+navic_block_writer::navic_block_writer() : file(NULL)
+{
+}
+
+navic_block_writer::~navic_block_writer()
+{
+  close();
+}
+
+bool navic_block_writer::open(const char *path)
+{
+  close();
+  file = fopen(path, "wb");
+  fixes.reserve(_NavIC_BLOCK_FIXES);
+  return file != NULL;
+}
+
+bool navic_block_writer::append(const NavIC_fix &fix)
+{
+  fixes.push_back(fix);
+  return fixes.size() < _NavIC_BLOCK_FIXES || flush();
+}
+
+bool navic_block_writer::flush()
+{
+  if (file == NULL)
+    return false;
+  if (fixes.empty())
+    return true;
+
+  block.assign(_NavIC_BLOCK_HEADER, 0);
+  for (int column = 0; column < _NavIC_BLOCK_COLUMNS; ++column)
+  {
+    int64_t prev = 0;
+    for (size_t i = 0; i < fixes.size(); ++i)
+    {
+      int64_t v = getColumn(fixes[i], column);
+      putVarint(block, v - prev);
+      prev = v;
+    }
+  }
+
+  memcpy(&block[0], "NVB1", 4);
+  put32(&block[4], (uint32_t)fixes.size());
+  put32(&block[8], (uint32_t)(block.size() - _NavIC_BLOCK_HEADER));
+  fixes.clear();
+  return fwrite(&block[0], 1, block.size(), file) == block.size();
+}
+
+bool navic_block_writer::close()
+{
+  if (file == NULL)
+    return true;
+  bool ok = flush();
+  ok = fclose(file) == 0 && ok;
+  file = NULL;
+  return ok;
+}
+
+navic_block_reader::navic_block_reader() : file(NULL), pos(NULL), end(NULL), cursor(0)
+{
+}
+
+navic_block_reader::~navic_block_reader()
+{
+  close();
+}
+
+bool navic_block_reader::open(const char *path)
+{
+  close();
+  file = new navic_mapped_file;
+  const char *data = NULL;
+  size_t len = 0;
+  if (!file->open(path, 0))
+  {
+    close();
+    return false;
+  }
+  file->next(data, len); // an empty file maps nothing
+  pos = (const uint8_t *)data;
+  end = pos + len;
+  return true;
+}
+
+void navic_block_reader::close()
+{
+  delete file;
+  file = NULL;
+  pos = end = NULL;
+  fixes.clear();
+  cursor = 0;
+}
+
+bool navic_block_reader::next(NavIC_fix &fix)
+{
+  if (cursor == fixes.size() && !decodeBlock())
+    return false;
+  fix = fixes[cursor++];
+  return true;
+}
+
+bool navic_block_reader::decodeBlock()
+{
+  fixes.clear();
+  cursor = 0;
+  if (end - pos < _NavIC_BLOCK_HEADER || memcmp(pos, "NVB1", 4) != 0)
+    return false;
+  uint32_t count = get32(pos + 4);
+  uint32_t payload = get32(pos + 8);
+  const uint8_t *p = pos + _NavIC_BLOCK_HEADER;
+  // every column takes at least a byte per fix, which bounds a corrupt count
+  if ((size_t)(end - p) < payload || count == 0 || count > payload / _NavIC_BLOCK_COLUMNS)
+    return false;
+  const uint8_t *blockEnd = p + payload;
+
+  fixes.assign(count, NavIC_fix());
+  for (int column = 0; column < _NavIC_BLOCK_COLUMNS; ++column)
+  {
+    int64_t v = 0, delta;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      if (!getVarint(p, blockEnd, delta))
+      {
+        fixes.clear();
+        return false;
+      }
+      v += delta;
+      setColumn(fixes[i], column, v);
+    }
+  }
+
+  pos = blockEnd;
+  return true;
+}
+
+#endif // _NavIC_HOST
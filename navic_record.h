@@ -0,0 +1,86 @@
+/*
+navic_record - compact binary storage for committed fixes
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+#ifndef __navic_record_h
+#define __navic_record_h
+
+#include "navic_rmc_gga++.h"
+
+// Fixed-width record: every NavIC_fix member but committed (unpacked as
+// 0), little-endian, RawDegrees stored as is.  Suitable for MCU logging
+// and random access.
+#define _NavIC_RECORD_SIZE 40
+
+void navic_record_pack(const NavIC_fix &fix, uint8_t *record);
+void navic_record_unpack(const uint8_t *record, NavIC_fix &fix);
+
+#ifdef _NavIC_HOST
+#include <stdio.h>
+#include <vector>
+
+// Columnar block format.  Each block holds up to _NavIC_BLOCK_FIXES fixes:
+//
+//   "NVB1" | u32 count | u32 payload length | payload
+//
+// where the payload stores each NavIC_fix member as its own column of
+// zigzag-encoded deltas from the previous fix, written as LEB128 varints.
+#define _NavIC_BLOCK_FIXES 4096
+
+class navic_block_writer
+{
+public:
+   navic_block_writer();
+   ~navic_block_writer();
+
+   bool open(const char *path);
+   bool append(const NavIC_fix &fix);
+   bool flush(); // writes the pending block, if any
+   bool close();
+
+private:
+   navic_block_writer(const navic_block_writer &);
+   navic_block_writer &operator=(const navic_block_writer &);
+
+   FILE *file;
+   std::vector<NavIC_fix> fixes;
+   std::vector<uint8_t> block;
+};
+
+class navic_mapped_file;
+
+// Reads a block file through a single read-only mapping of it
+class navic_block_reader
+{
+public:
+   navic_block_reader();
+   ~navic_block_reader();
+
+   bool open(const char *path);
+   void close();
+
+   // next fix in file order; returns false at end of file or on a bad block
+   bool next(NavIC_fix &fix);
+
+private:
+   navic_block_reader(const navic_block_reader &);
+   navic_block_reader &operator=(const navic_block_reader &);
+
+   bool decodeBlock();
+
+   navic_mapped_file *file;
+   const uint8_t *pos, *end;
+   std::vector<NavIC_fix> fixes;
+   size_t cursor;
+};
+
+#endif // _NavIC_HOST
+#endif // def(__navic_record_h)
@@ -0,0 +1,166 @@
+/*
+navic_replay - parallel re-decoding of recorded NMEA captures (host only)
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_replay.h"
+
+#ifdef _NavIC_HOST
+#include <string.h>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+struct Chunk
+{
+  const char *begin;
+  size_t len;
+  NavIC_replay_result out;
+};
+
+// Per-worker deque: the owner takes from the front, thieves from the back
+struct WorkQueue
+{
+  std::mutex lock;
+  std::deque<size_t> items;
+
+  bool pop(size_t &item)
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if (items.empty())
+      return false;
+    item = items.front();
+    items.pop_front();
+    return true;
+  }
+
+  bool steal(size_t &item)
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if (items.empty())
+      return false;
+    item = items.back();
+    items.pop_back();
+    return true;
+  }
+};
+}
+
+// Feeds the chunk one sentence at a time so the fix can be captured after
+// every sentence that validates
+static void decodeChunk(Chunk &chunk)
+{
+  navic_gn_rmc_gga navic;
+  const char *p = chunk.begin;
+  const char *end = p + chunk.len;
+
+  while (p < end)
+  {
+    const char *next = p + 1 < end ? (const char *)memchr(p + 1, '$', end - p - 1) : NULL;
+    if (next == NULL)
+      next = end;
+    if (navic.encode(p, next - p))
+    {
+      NavIC_fix fix;
+      navic.snapshot(fix);
+      if (fix.sentence == navic_gn_rmc_gga::NAVIC_SENTENCE_RMC || fix.sentence == navic_gn_rmc_gga::NAVIC_SENTENCE_GGA)
+        chunk.out.fixes.push_back(fix);
+    }
+    p = next;
+  }
+
+  chunk.out.charsProcessed = navic.charsProcessed();
+  chunk.out.passedChecksum = navic.passedChecksum();
+  chunk.out.failedChecksum = navic.failedChecksum();
+}
+
+static void worker(std::vector<Chunk> &chunks, std::vector<WorkQueue> &queues, size_t self)
+{
+  size_t item;
+  for (;;)
+  {
+    if (queues[self].pop(item))
+    {
+      decodeChunk(chunks[item]);
+      continue;
+    }
+
+    // All chunks are queued up front, so a full sweep that finds nothing
+    // to steal means there is no work left
+    bool stolen = false;
+    for (size_t i = 1; i < queues.size() && !stolen; ++i)
+      stolen = queues[(self + i) % queues.size()].steal(item);
+    if (!stolen)
+      return;
+    decodeChunk(chunks[item]);
+  }
+}
+
+void navic_replay(const char *buf, size_t len, NavIC_replay_result &result, unsigned threads, size_t chunkSize)
+{
+  std::vector<Chunk> chunks;
+  size_t pos = 0;
+  while (pos < len)
+  {
+    size_t stop = len;
+    if (len - pos > chunkSize)
+    {
+      const char *next = (const char *)memchr(buf + pos + chunkSize, '$', len - pos - chunkSize);
+      if (next != NULL)
+        stop = next - buf;
+    }
+    Chunk chunk;
+    chunk.begin = buf + pos;
+    chunk.len = stop - pos;
+    chunks.push_back(chunk);
+    pos = stop;
+  }
+
+  if (threads == 0)
+    threads = std::thread::hardware_concurrency();
+  if (threads == 0)
+    threads = 1;
+  if (threads > chunks.size())
+    threads = chunks.size();
+
+  if (threads <= 1)
+  {
+    for (size_t i = 0; i < chunks.size(); ++i)
+      decodeChunk(chunks[i]);
+  }
+  else
+  {
+    // Contiguous runs of chunks per worker keep neighbours on one core
+    // until the load becomes uneven and stealing kicks in
+    std::vector<WorkQueue> queues(threads);
+    for (size_t i = 0; i < chunks.size(); ++i)
+      queues[i * threads / chunks.size()].items.push_back(i);
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; ++t)
+      pool.push_back(std::thread(worker, std::ref(chunks), std::ref(queues), t));
+    for (unsigned t = 0; t < threads; ++t)
+      pool[t].join();
+  }
+
+  for (size_t i = 0; i < chunks.size(); ++i)
+  {
+    const NavIC_replay_result &out = chunks[i].out;
+    result.fixes.insert(result.fixes.end(), out.fixes.begin(), out.fixes.end());
+    result.charsProcessed += out.charsProcessed;
+    result.passedChecksum += out.passedChecksum;
+    result.failedChecksum += out.failedChecksum;
+  }
+}
+
+#endif // _NavIC_HOST
@@ -0,0 +1,43 @@
+/*
+navic_replay - parallel re-decoding of recorded NMEA captures (host only)
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+#ifndef __navic_replay_h
+#define __navic_replay_h
+
+#include "navic_rmc_gga++.h"
+
+#ifdef _NavIC_HOST
+#include <vector>
+
+#define _NavIC_REPLAY_CHUNK_SIZE (4UL << 20)
+
+struct NavIC_replay_result
+{
+   std::vector<NavIC_fix> fixes; // one per committed RMC/GGA, in file order
+   uint64_t charsProcessed; // totals over all chunks, so 64 bits for multi-GB captures
+   uint64_t passedChecksum;
+   uint64_t failedChecksum;
+
+   NavIC_replay_result() : charsProcessed(0), passedChecksum(0), failedChecksum(0)
+   {
+   }
+};
+
+// Splits buf at '$' boundaries into chunks of roughly chunkSize bytes and
+// decodes them on a work-stealing pool of threads (0 = one per core), each
+// chunk with a fresh navic_gn_rmc_gga.  Fixes are merged back in file order;
+// the fields mask of a snapshot only covers what its own chunk has seen.
+void navic_replay(const char *buf, size_t len, NavIC_replay_result &result,
+                  unsigned threads = 0, size_t chunkSize = _NavIC_REPLAY_CHUNK_SIZE);
+
+#endif // _NavIC_HOST
+#endif // def(__navic_replay_h)
@@ -0,0 +1,141 @@
+/*
+navic_ring - lock-free UART receive ring, filled a byte at a time from an
+interrupt and drained into a parser a sentence at a time
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+#ifndef __navic_ring_h
+#define __navic_ring_h
+
+#include "navic_rmc_gga++.h"
+
+// Indices the other side can load or store in one instruction: a byte on
+// 8-bit AVR, where the ring is then at most 256 bytes
+#ifdef __AVR__
+typedef uint8_t navic_ring_index;
+#else
+typedef uint32_t navic_ring_index;
+#endif
+
+#if defined(__GNUC__)
+#define _NavIC_LOAD_ACQUIRE(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define _NavIC_STORE_RELEASE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#else
+// enough on single-core MCUs, whose only concurrency is the interrupt
+#define _NavIC_LOAD_ACQUIRE(p) (*(volatile navic_ring_index *)(p))
+#define _NavIC_STORE_RELEASE(p, v) (*(volatile navic_ring_index *)(p) = (v))
+#endif
+
+// Single-producer, single-consumer byte ring between a UART receive
+// interrupt (or DMA completion callback) and the main loop.  put() costs a
+// few instructions and never blocks: it keeps bytes from '$' on and hands
+// them to the consumer only when the '\n' that ends the sentence (or the
+// '$' of the next) arrives.  drain() then feeds all whole sentences to a
+// parser in one bulk encode(), so term decoding runs outside the
+// interrupt.  If the ring fills, put() drops the sentence in progress
+// rather than a byte in the middle of one.
+//
+// Size must be a power of two; one byte is kept free to tell full from
+// empty.
+template <size_t Size>
+class navic_uart_ring
+{
+public:
+   navic_uart_ring() : head(0), tail(0), write(0), inSentence(false), droppedCount(0)
+   {
+      static_assert((Size & (Size - 1)) == 0, "Size must be a power of two");
+      static_assert(Size - 1 <= (navic_ring_index)~(navic_ring_index)0, "Size too large for navic_ring_index");
+   }
+
+   // Producer side: from the receive interrupt.  Returns false if the byte
+   // was not kept (outside a sentence, or dropped for lack of room).
+   bool put(char c)
+   {
+      if (c == '$')
+      {
+         // a sentence cut short is passed on for the parser to count
+         if (inSentence)
+            _NavIC_STORE_RELEASE(&head, write);
+         inSentence = true;
+      }
+      else if (!inSentence)
+         return false;
+
+      navic_ring_index next = (write + 1) & (Size - 1);
+      if (next == _NavIC_LOAD_ACQUIRE(&tail))
+      {
+         write = head;
+         inSentence = false;
+         ++droppedCount;
+         return false;
+      }
+      buffer[write] = c;
+      write = next;
+      if (c == '\n')
+      {
+         _NavIC_STORE_RELEASE(&head, write);
+         inSentence = false;
+      }
+      return true;
+   }
+
+   // For a DMA half/full-transfer callback
+   size_t put(const char *buf, size_t len)
+   {
+      size_t kept = 0;
+      for (size_t i = 0; i < len; ++i)
+         kept += put(buf[i]);
+      return kept;
+   }
+
+   // Consumer side: feeds every sentence received so far to navic (a
+   // navic_gn_rmc_gga, navic_parser<Fields> or anything with a bulk
+   // encode()) and frees their space; returns sentences validated
+   template <class Parser>
+   size_t drain(Parser &navic)
+   {
+      navic_ring_index h = _NavIC_LOAD_ACQUIRE(&head), t = tail;
+      size_t sentences = 0;
+      if (h < t)
+      {
+         sentences += navic.encode(buffer + t, Size - t);
+         t = 0;
+      }
+      if (t < h)
+         sentences += navic.encode(buffer + t, h - t);
+      _NavIC_STORE_RELEASE(&tail, h);
+      return sentences;
+   }
+
+   // bytes of whole sentences waiting for drain()
+   size_t available() const
+   {
+      return (_NavIC_LOAD_ACQUIRE(&head) - tail) & (Size - 1);
+   }
+   static size_t capacity() { return Size - 1; }
+   // Sentences put() had no room for.  Written by the producer: on 8-bit
+   // MCUs read it with interrupts off.
+   uint32_t dropped() const { return droppedCount; }
+
+private:
+   navic_uart_ring(const navic_uart_ring &);
+   navic_uart_ring &operator=(const navic_uart_ring &);
+
+   char buffer[Size];
+   navic_ring_index head; // end of the last whole sentence; producer stores
+   navic_ring_index tail; // start of what drain() has not taken; consumer stores
+
+   // producer only
+   navic_ring_index write;
+   bool inSentence;
+   volatile uint32_t droppedCount;
+};
+
+#endif // def(__navic_ring_h)
@@ -20,11 +20,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef __navic_gn_rmc_gga_h
 #define __navic_gn_rmc_gga_h
 
-#if defined(ARDUINO) && ARDUINO >= 100
-#include "Arduino.h"
-#else
-#include "WProgram.h"
-#endif
+#include "navic_platform.h"
 #include <limits.h>
 
 #define _NavIC_VERSION "1.0.3" // software version of this library
@@ -35,6 +31,58 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define _NavIC_KM_PER_METER 0.001
 #define _NavIC_FEET_PER_METER 3.2808399
 #define _NavIC_MAX_FIELD_SIZE 15
+#ifdef _NavIC_SWAR_DIGITS
+#define _NavIC_TERM_PADDING 8 // readable bytes past a term for 8-digit loads
+#else
+#define _NavIC_TERM_PADDING 0
+#endif
+#define _NavIC_FRACTION_DIGITS 7 // fraction digits kept by NavIC_number
+#ifndef _NavIC_MAX_SATELLITES
+#define _NavIC_MAX_SATELLITES 32 // GSV and GSA entries kept across all talkers
+#endif
+#define _NavIC_MAX_ACTIVE_SATELLITES 12 // PRN slots in a GSA sentence
+#define _NavIC_CUSTOM_SLOTS 16 // sentence types with NavIC_CUSTOM listeners (power of 2)
+
+// Sentence names of up to 8 characters packed into an integer, first
+// character in the low byte, for switch-based and hashed dispatch.  A
+// standard name is a 2-character talker followed by a 3-character type.
+#define _NavIC_TAG2(a, b) ((uint16_t)(a) | (uint16_t)(b) << 8)
+#define _NavIC_TAG3(a, b, c) ((uint32_t)(a) | (uint32_t)(b) << 8 | (uint32_t)(c) << 16)
+
+// Keep the last fix of every talker (GP, GI, GN, ...) for side-by-side
+// comparison; costs one NavIC_fix of RAM per talker
+#ifndef _NavIC_TALKER_FIXES
+#ifdef _NavIC_HOST
+#define _NavIC_TALKER_FIXES 1
+#else
+#define _NavIC_TALKER_FIXES 0
+#endif
+#endif
+
+// encode(char) accumulates numeric terms digit by digit as they arrive,
+// instead of copying each term and parsing it at its end, which saves the
+// term buffer and lifts its _NavIC_MAX_FIELD_SIZE limit.  On by default
+// on hosts, where it measures faster; boards keep the copy until it has
+// been measured there.  The bulk encode() reads whole terms in place
+// either way.
+#ifndef _NavIC_INCREMENTAL_TERMS
+#ifdef _NavIC_HOST
+#define _NavIC_INCREMENTAL_TERMS 1
+#else
+#define _NavIC_INCREMENTAL_TERMS 0
+#endif
+#endif
+
+// Count sentences per type, truncated sentences and over-long terms, and
+// time the parser's stages with navic_cycles(); see NavIC_stats.  Off by
+// default, and then costs nothing.
+#ifndef _NavIC_STATS
+#define _NavIC_STATS 0
+#endif
+#ifndef _NavIC_LATENCY_BUCKETS
+#define _NavIC_LATENCY_BUCKETS 32 // log2 buckets of '$' to commit latency
+#endif
+#define _NavIC_SENTENCE_TYPES 5 // navic_gn_rmc_gga::NAVIC_SENTENCE_GGA .. _OTHER
 
 struct RawDegrees
 {
@@ -46,6 +94,90 @@ public:
    RawDegrees() : deg(0), billionths(0), negative(false)
    {
    }
+
+   // signed degrees * 10^7 (about 1.1 cm), in integer arithmetic only
+   int32_t e7() const
+   {
+      int32_t ret = deg * 10000000L + (int32_t)((billionths + 50) / 100);
+      return negative ? -ret : ret;
+   }
+};
+
+// A numeric term, -xxxx.yyyyyyy, parsed from the whole term or, with
+// _NavIC_INCREMENTAL_TERMS, accumulated one character at a time as it
+// arrives.  Reading stops at the first character that does not fit, with
+// the same results as the navic_digits.h parsers on the whole term.
+struct NavIC_number
+{
+   enum
+   {
+      START,
+      WHOLE,
+      FRACTION,
+      DONE
+   };
+
+   uint32_t whole;
+   uint32_t fraction; // ten-millionths once finish()ed
+   uint8_t fractionDigits;
+   uint8_t state;
+   bool negative;
+
+   void reset()
+   {
+      whole = fraction = 0;
+      fractionDigits = 0;
+      state = START;
+      negative = false;
+   }
+
+   void add(char c)
+   {
+      // digits past the 7th of the fraction are skipped by ending there
+      uint8_t digit = (uint8_t)(c - '0');
+      if (digit < 10 && state < FRACTION)
+      {
+         whole = whole * 10 + digit;
+         state = WHOLE;
+      }
+      else if (digit < 10 && state == FRACTION)
+      {
+         fraction = fraction * 10 + digit;
+         if (++fractionDigits == _NavIC_FRACTION_DIGITS)
+            state = DONE;
+      }
+      else if (c == '-' && state == START)
+      {
+         negative = true;
+         state = WHOLE;
+      }
+      else if (c == '.' && state < FRACTION)
+         state = FRACTION;
+      else
+         state = DONE;
+   }
+
+   // scale a fraction of fewer than 7 digits to ten-millionths
+   void finish()
+   {
+      for (; fractionDigits < _NavIC_FRACTION_DIGITS; ++fractionDigits)
+         fraction *= 10;
+   }
+
+   uint32_t unsignedValue() const { return negative ? 0 : whole; }
+   int32_t signedValue() const { return negative ? -(int32_t)whole : (int32_t)whole; }
+   int32_t hundredths() const // as navic_parse_decimal(term, 2)
+   {
+      int32_t ret = (int32_t)(whole * 100 + fraction / 100000);
+      return negative ? -ret : ret;
+   }
+   void toDegrees(RawDegrees &deg) const // NMEA DDDMM.MMMMMMM, as navic_parse_degrees()
+   {
+      uint32_t tenMillionthsOfMinutes = negative ? 0 : whole % 100 * 10000000UL + fraction;
+      deg.deg = negative ? 0 : (uint16_t)(whole / 100);
+      deg.billionths = (5 * tenMillionthsOfMinutes + 1) / 3;
+      deg.negative = false;
+   }
 };
 
 struct NavIC_Location
@@ -55,7 +187,7 @@ struct NavIC_Location
 public:
    bool isValid() const { return valid; }
    bool isUpdated() const { return updated; }
-   uint32_t age() const { return valid ? millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
+   uint32_t age() const { return valid ? navic_millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
    const RawDegrees &rawLat()
    {
       updated = false;
@@ -68,6 +200,16 @@ public:
    }
    double lat();
    double lng();
+   int32_t latE7() // degrees * 10^7, no floating point
+   {
+      updated = false;
+      return rawLatData.e7();
+   }
+   int32_t lngE7()
+   {
+      updated = false;
+      return rawLngData.e7();
+   }
 
    NavIC_Location() : valid(false), updated(false)
    {
@@ -78,8 +220,8 @@ private:
    RawDegrees rawLatData, rawLngData, rawNewLatData, rawNewLngData;
    uint32_t lastCommitTime;
    void commit();
-   void setLatitude(const char *term);
-   void setLongitude(const char *term);
+   void setLatitude(const NavIC_number &term);
+   void setLongitude(const NavIC_number &term);
 };
 
 struct NavIC_date
@@ -89,7 +231,7 @@ struct NavIC_date
 public:
    bool isValid() const { return valid; }
    bool isUpdated() const { return updated; }
-   uint32_t age() const { return valid ? millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
+   uint32_t age() const { return valid ? navic_millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
 
    uint32_t value()
    {
@@ -100,7 +242,7 @@ public:
    uint8_t month();
    uint8_t day();
 
-   NavIC_date() : valid(false), updated(false), date(0)
+   NavIC_date() : valid(false), updated(false), date(0), newDate(0)
    {
    }
 
@@ -109,7 +251,7 @@ private:
    uint32_t date, newDate;
    uint32_t lastCommitTime;
    void commit();
-   void setDate(const char *term);
+   void setDate(const NavIC_number &term);
 };
 
 struct NavIC_time
@@ -119,7 +261,7 @@ struct NavIC_time
 public:
    bool isValid() const { return valid; }
    bool isUpdated() const { return updated; }
-   uint32_t age() const { return valid ? millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
+   uint32_t age() const { return valid ? navic_millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
 
    uint32_t value()
    {
@@ -131,7 +273,7 @@ public:
    uint8_t second();
    uint8_t centisecond();
 
-   NavIC_time() : valid(false), updated(false), time(0)
+   NavIC_time() : valid(false), updated(false), time(0), newTime(0)
    {
    }
 
@@ -140,7 +282,7 @@ private:
    uint32_t time, newTime;
    uint32_t lastCommitTime;
    void commit();
-   void setTime(const char *term);
+   void setTime(const NavIC_number &term);
 };
 
 struct NavIC_decimal
@@ -150,14 +292,14 @@ struct NavIC_decimal
 public:
    bool isValid() const { return valid; }
    bool isUpdated() const { return updated; }
-   uint32_t age() const { return valid ? millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
+   uint32_t age() const { return valid ? navic_millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
    int32_t value()
    {
       updated = false;
       return val;
    }
 
-   NavIC_decimal() : valid(false), updated(false), val(0)
+   NavIC_decimal() : valid(false), updated(false), val(0), newval(0)
    {
    }
 
@@ -166,7 +308,7 @@ private:
    uint32_t lastCommitTime;
    int32_t val, newval;
    void commit();
-   void set(const char *term);
+   void set(const NavIC_number &term);
 };
 
 struct NavIC_integer
@@ -176,14 +318,14 @@ struct NavIC_integer
 public:
    bool isValid() const { return valid; }
    bool isUpdated() const { return updated; }
-   uint32_t age() const { return valid ? millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
+   uint32_t age() const { return valid ? navic_millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
    uint32_t value()
    {
       updated = false;
       return val;
    }
 
-   NavIC_integer() : valid(false), updated(false), val(0)
+   NavIC_integer() : valid(false), updated(false), val(0), newval(0)
    {
    }
 
@@ -192,11 +334,22 @@ private:
    uint32_t lastCommitTime;
    uint32_t val, newval;
    void commit();
-   void set(const char *term);
+   void set(const NavIC_number &term);
 };
 
+// num / den rounded to nearest, halves away from zero
+static inline int32_t navic_div_round(int32_t num, int32_t den)
+{
+   return (num + (num < 0 ? -den : den) / 2) / den;
+}
+
+// The integer accessors below avoid floating point altogether, for targets
+// without an FPU; they round to the nearest unit.
 struct NavIC_speed : NavIC_decimal
 {
+   int32_t centiKnots() { return value(); }
+   int32_t cmps() { return navic_div_round(value() * 1852L, 3600); }   // cm/s, up to 11,000 knots
+   int32_t centiKmph() { return navic_div_round(value() * 1852L, 1000); }
    double knots() { return value() / 100.0; }
    double mph() { return _NavIC_MPH_PER_KNOT * value() / 100.0; }
    double mps() { return _NavIC_MPS_PER_KNOT * value() / 100.0; }
@@ -205,11 +358,13 @@ struct NavIC_speed : NavIC_decimal
 
 struct NavIC_course : public NavIC_decimal
 {
+   int32_t centiDegrees() { return value(); }
    double deg() { return value() / 100.0; }
 };
 
 struct NavIC_altitudes : NavIC_decimal
 {
+   int32_t centimeters() { return value(); }
    double meters() { return value() / 100.0; }
    double miles() { return _NavIC_MILES_PER_METER * value() / 100.0; }
    double kilometers() { return _NavIC_KM_PER_METER * value() / 100.0; }
@@ -221,17 +376,185 @@ struct NavIC_HDOP : NavIC_decimal
    double hdop() { return value() / 100.0; }
 };
 
+// Satellites in view from GSV, one entry per satellite, stored as parallel
+// arrays.  A talker's multi-part GSV sequence is staged in the free tail of
+// the arrays and replaces that talker's entries only once its last part has
+// passed its checksum.  When the tail is too short for the satellites the
+// first part announces, the talker's old entries are moved to the end and
+// overwritten in place instead; should that sequence break off, they are
+// dropped.  Satellites beyond _NavIC_MAX_SATELLITES are dropped.
+struct NavIC_satellites_in_view
+{
+   friend class navic_gn_rmc_gga;
+
+public:
+   bool isValid() const { return valid; }
+   bool isUpdated() const { return updated; }
+   uint32_t age() const { return valid ? navic_millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
+   uint8_t count()
+   {
+      updated = false;
+      return n;
+   }
+   uint8_t prn(uint8_t i) const { return prns[i]; }
+   int8_t elevation(uint8_t i) const { return elevations[i]; } // degrees
+   uint16_t azimuth(uint8_t i) const { return azimuths[i]; }   // degrees true
+   uint8_t snr(uint8_t i) const { return snrs[i]; }            // dB-Hz, 0 when not tracked
+   uint8_t talker(uint8_t i) const { return talkers[i]; }      // navic_gn_rmc_gga::NAVIC_TALKER_*
+
+   NavIC_satellites_in_view() : valid(false), updated(false), n(0), staged(0), sentenceStaged(0), seqTalker(0), seqTotal(0), seqNext(0), seqBase(0)
+   {
+   }
+
+private:
+   bool valid, updated;
+   uint32_t lastCommitTime;
+   uint8_t n, staged, sentenceStaged;
+   uint8_t seqTalker, seqTotal, seqNext;
+   uint8_t seqBase; // where the sequence is staged: n, or the talker's old entries
+   uint8_t prns[_NavIC_MAX_SATELLITES];
+   int8_t elevations[_NavIC_MAX_SATELLITES];
+   uint16_t azimuths[_NavIC_MAX_SATELLITES];
+   uint8_t snrs[_NavIC_MAX_SATELLITES];
+   uint8_t talkers[_NavIC_MAX_SATELLITES];
+   void setTerm(uint8_t talker, uint8_t termNumber, const NavIC_number &term);
+   void commit(uint8_t termCount);
+   void abandon();
+   void makeRoom(uint8_t needed);
+};
+
+// Satellites used from GSA, one entry per satellite like the GSV table.  A
+// combined receiver sends one GSA per constellation each epoch, told apart
+// by talker and, for GN, the NMEA 4.10 system ID; each GSA replaces only
+// the entries of its own talker and system, so GN GSAs without a system
+// ID replace one another.  Fix type and DOPs are those
+// of the last GSA, which a combined solution repeats in every one.
+// Satellites beyond _NavIC_MAX_SATELLITES are dropped.
+struct NavIC_active_satellites
+{
+   friend class navic_gn_rmc_gga;
+
+public:
+   bool isValid() const { return valid; }
+   bool isUpdated() const { return updated; }
+   uint32_t age() const { return valid ? navic_millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
+   uint8_t fixType() // 1 = none, 2 = 2D, 3 = 3D
+   {
+      updated = false;
+      return type;
+   }
+   uint8_t count() const { return n; }
+   uint8_t prn(uint8_t i) const { return prns[i]; }
+   uint8_t talker(uint8_t i) const { return talkers[i]; } // navic_gn_rmc_gga::NAVIC_TALKER_*
+   uint8_t systemId(uint8_t i) const { return systems[i]; }
+   double pdop() const { return pdopVal / 100.0; }
+   double hdop() const { return hdopVal / 100.0; }
+   double vdop() const { return vdopVal / 100.0; }
+   uint8_t systemId() const { return system; } // NMEA 4.10 GNSS system ID of the last GSA, 0 if absent
+
+   NavIC_active_satellites() : valid(false), updated(false), type(0), n(0), system(0), pdopVal(0), hdopVal(0), vdopVal(0), newType(0), newN(0), newTalker(0), newSystem(0)
+   {
+   }
+
+private:
+   bool valid, updated;
+   uint32_t lastCommitTime;
+   uint8_t type, n, system;
+   uint8_t prns[_NavIC_MAX_SATELLITES];
+   uint8_t talkers[_NavIC_MAX_SATELLITES];
+   uint8_t systems[_NavIC_MAX_SATELLITES];
+   int32_t pdopVal, hdopVal, vdopVal;
+   uint8_t newType, newN, newTalker, newSystem;
+   uint8_t newPrns[_NavIC_MAX_ACTIVE_SATELLITES];
+   int32_t newPdop, newHdop, newVdop;
+   void setTerm(uint8_t talker, uint8_t termNumber, const NavIC_number &term, const char *head);
+   void commit();
+};
+
+// Plain copy of the committed values, independent of the isUpdated() flags.
+// Units are those of the raw members: hhmmsscc, ddmmyy and hundredths of
+// knots, degrees, meters and HDOP.
+struct NavIC_fix
+{
+   enum
+   {
+      LOCATION = 0x01,
+      DATE = 0x02,
+      TIME = 0x04,
+      SPEED = 0x08,
+      COURSE = 0x10,
+      ALTITUDE = 0x20,
+      SATELLITES = 0x40,
+      HDOP = 0x80
+   };
+
+   RawDegrees lat, lng;
+   uint32_t date;
+   uint32_t time;
+   int32_t speed;
+   int32_t course;
+   int32_t altitude;
+   uint32_t satellites;
+   int32_t hdop;
+   uint8_t sentence;  // navic_gn_rmc_gga::NAVIC_SENTENCE_* last committed
+   uint8_t talker;    // navic_gn_rmc_gga::NAVIC_TALKER_* of that sentence
+   uint8_t fields;    // bitmask of the members above that are valid
+   uint8_t committed; // bitmask of the members that sentence committed
+
+   NavIC_fix() : date(0), time(0), speed(0), course(0), altitude(0), satellites(0), hdop(0), sentence(0), talker(0), fields(0), committed(0)
+   {
+   }
+};
+
+#if _NavIC_STATS
+// Parser counters, indexed by navic_gn_rmc_gga::NAVIC_SENTENCE_* where
+// per type; _OTHER counts sentences that were checked but not decoded.
+// Times are in navic_cycles() ticks.
+struct NavIC_stats
+{
+   enum
+   {
+      STAGE_FRAMING, // bulk encode() outside the stages below
+      STAGE_LOOKUP,  // sentence name to type and custom listeners
+      STAGE_FIELDS,  // decoding terms into fields and custom values
+      STAGE_COMMIT,  // checksum test, commit and listener callbacks
+      STAGES
+   };
+
+   uint32_t passed[_NavIC_SENTENCE_TYPES];
+   uint32_t failed[_NavIC_SENTENCE_TYPES];
+   uint32_t truncated;     // cut short by the next '$' before the checksum
+   uint32_t termOverflows; // terms longer than _NavIC_MAX_FIELD_SIZE - 1
+   // latency[i] counts sentences committed 2^i to 2^(i+1) - 1 ticks after
+   // their '$' (bucket 0 from 0); the last bucket takes all longer ones
+   uint32_t latency[_NavIC_LATENCY_BUCKETS];
+   // Ticks spent in each stage.  encode(char) only times the stages
+   // that end a term, since the caller runs between its characters.
+   uint64_t cycles[STAGES];
+};
+#endif
+
+#define _NavIC_SENTENCE_MASK(type) (1U << (type))
+#define _NavIC_FIX_SENTENCES (_NavIC_SENTENCE_MASK(navic_gn_rmc_gga::NAVIC_SENTENCE_RMC) | _NavIC_SENTENCE_MASK(navic_gn_rmc_gga::NAVIC_SENTENCE_GGA))
+
+typedef void (*NavIC_fix_callback)(const NavIC_fix &fix, void *context);
+
 class navic_gn_rmc_gga;
+class navic_sentence_cache;
 class NavIC_CUSTOM
 {
 public:
-   NavIC_CUSTOM(){};
+   NavIC_CUSTOM() : tag(0) {};
+   // Check isAttached() afterwards: the constructor cannot return begin()'s
    NavIC_CUSTOM(navic_gn_rmc_gga &navic, const char *sentenceName, int termNumber);
-   void begin(navic_gn_rmc_gga &navic, const char *_sentenceName, int _termNumber);
+   // Returns false, and does not listen, for a sentence name that is empty
+   // or longer than the 8 characters a tag holds
+   bool begin(navic_gn_rmc_gga &navic, const char *_sentenceName, int _termNumber);
+   bool isAttached() const { return tag != 0; } // by a begin() that returned true
 
    bool isUpdated() const { return updated; }
    bool isValid() const { return valid; }
-   uint32_t age() const { return valid ? millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
+   uint32_t age() const { return valid ? navic_millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
    const char *value()
    {
       updated = false;
@@ -240,23 +563,61 @@ public:
 
 private:
    void commit();
-   void set(const char *term);
+   void materialize();
 
    char stagingBuffer[_NavIC_MAX_FIELD_SIZE + 1];
    char buffer[_NavIC_MAX_FIELD_SIZE + 1];
+   // The value of the current sentence: stagingBuffer, buffer (unchanged
+   // since the last commit) or, within a bulk encode(), the term in place
+   // in the caller's buffer
+   const char *staged;
+   uint8_t stagedLength;
    unsigned long lastCommitTime;
    bool valid, updated;
    const char *sentenceName;
+   uint64_t tag; // packed sentenceName
    int termNumber;
    friend class navic_gn_rmc_gga;
    NavIC_CUSTOM *next;
 };
 
+// Calls back with a snapshot of the committed values each time a sentence
+// whose bit is set in sentences (_NavIC_SENTENCE_MASK) passes its checksum.
+// The snapshot is taken once per sentence and shared by all listeners, and
+// never touches the isUpdated() flags.  A callback may end() its own
+// listener; a parser destroyed first detaches its listeners.
+class NavIC_LISTENER
+{
+public:
+   NavIC_LISTENER() : navic(0), next(0){};
+   NavIC_LISTENER(navic_gn_rmc_gga &navic, NavIC_fix_callback callback, void *context = 0, uint16_t sentences = 0);
+   ~NavIC_LISTENER() { end(); }
+   void begin(navic_gn_rmc_gga &navic, NavIC_fix_callback callback, void *context = 0, uint16_t sentences = 0);
+   void end(); // unsubscribe
+
+private:
+   NavIC_LISTENER(const NavIC_LISTENER &);
+   NavIC_LISTENER &operator=(const NavIC_LISTENER &);
+
+   NavIC_fix_callback callback;
+   void *context;
+   uint16_t sentenceMask;
+   navic_gn_rmc_gga *navic;
+   friend class navic_gn_rmc_gga;
+   NavIC_LISTENER *next;
+};
+
 class navic_gn_rmc_gga
 {
 public:
    navic_gn_rmc_gga();
+   ~navic_gn_rmc_gga();
    bool encode(char c); // process one character received from navic
+   size_t encode(const char *buf, size_t len); // process a buffer; returns sentences validated
+   size_t validateChecksums(const char *buf, size_t len); // checksum-only pass; returns bytes consumed
+   // Skip sentences the cache has seen, in the bulk encode() (see
+   // navic_dedup.h); NULL turns it off
+   void dedup(navic_sentence_cache *cache) { sentenceCache = cache; }
    navic_gn_rmc_gga &operator<<(char c)
    {
       encode(c);
@@ -272,14 +633,24 @@ public:
    NavIC_altitudes altitude;
    NavIC_integer satellites;
    NavIC_HDOP hdop;
+   NavIC_satellites_in_view satellitesInView;
+   NavIC_active_satellites activeSatellites;
 
    static const char *libraryVersion() { return _NavIC_VERSION; }
 
    static double distanceBetween(double lat1, double long1, double lat2, double long2);
    static double courseTo(double lat1, double long1, double lat2, double long2);
+   // Integer-only counterparts on degrees * 10^7 (see RawDegrees::e7()) for
+   // fixes up to a degree apart: distance in centimeters, within 5 cm plus
+   // 0.03%, and course in hundredths of a degree, within 0.2 degree beyond
+   // 10 m.  Flat-earth away from the poles, great circle within 10 degrees
+   // of one; a pole has no longitude, so the course from it is due south
+   // (north pole) or due north (south pole)
+   static uint32_t distanceBetweenE7(int32_t lat1, int32_t long1, int32_t lat2, int32_t long2);
+   static uint16_t courseToE7(int32_t lat1, int32_t long1, int32_t lat2, int32_t long2);
    static const char *cardinal(double course);
 
-   static int32_t parseDecimal(const char *term);
+   static int32_t parseDecimal(const char *term, uint8_t places = 2); // scaled by 10^places (at most 8)
    static void parseDegrees(const char *term, RawDegrees &deg);
 
    uint32_t charsProcessed() const { return encodedCharCount; }
@@ -287,38 +658,171 @@ public:
    uint32_t failedChecksum() const { return failedChecksumCount; }
    uint32_t passedChecksum() const { return passedChecksumCount; }
 
-private:
+   void snapshot(NavIC_fix &fix) const; // copy of the committed values
+#if _NavIC_STATS
+   const NavIC_stats &stats() const { return statistics; }
+   void resetStats();
+#endif
+#if _NavIC_TALKER_FIXES
+   // values committed by sentences of one talker only
+   const NavIC_fix &talkerFix(uint8_t talker) const { return talkerFixes[talker]; }
+#endif
+
    enum
    {
-      NAVIC_SENTENCE_GPGGA,
-      NAVIC_SENTENCE_GPRMC,
+      NAVIC_SENTENCE_GGA,
+      NAVIC_SENTENCE_RMC,
+      NAVIC_SENTENCE_GSV,
+      NAVIC_SENTENCE_GSA,
       NAVIC_SENTENCE_OTHER
    };
 
+   enum
+   {
+      NAVIC_TALKER_GP, // GPS
+      NAVIC_TALKER_GL, // GLONASS
+      NAVIC_TALKER_GA, // Galileo
+      NAVIC_TALKER_GB, // BeiDou (also BD)
+      NAVIC_TALKER_GI, // NavIC / IRNSS
+      NAVIC_TALKER_GQ, // QZSS
+      NAVIC_TALKER_GN, // combined solution
+      NAVIC_TALKER_OTHER
+   };
+
+private:
    // parsing state variables
    uint8_t parity;
    bool isChecksumTerm;
-   char term[_NavIC_MAX_FIELD_SIZE];
+   char termHead[3];       // first two characters of the term, for flags and the checksum
+   uint64_t curTag;        // sentence name so far, as sentenceTag()
+   NavIC_number termValue; // the term read as a number
+#if !_NavIC_INCREMENTAL_TERMS
+   char term[_NavIC_MAX_FIELD_SIZE + _NavIC_TERM_PADDING]; // copy of a term fed byte by byte
+#endif
+   const char *termStart;  // the term in place, within a bulk encode()
+   bool termPadded;        // 8 readable bytes follow termStart's term
+   bool termIsNumber;      // termValue is read from the term
    uint8_t curSentenceType;
+   uint8_t curTalker;
+   uint8_t lastSentenceType;
+   uint8_t lastTalker;
    uint8_t curTermNumber;
-   uint8_t curTermOffset;
+   uint8_t curTermOffset; // length of the term so far, saturating at 255
    bool sentenceHasFix;
+   navic_sentence_cache *sentenceCache;
 
    // custom element support
    friend class NavIC_CUSTOM;
    NavIC_CUSTOM *customElts;
-   NavIC_CUSTOM *customCandidates;
+   NavIC_CUSTOM *customCandidates; // first listener of the current sentence
+   NavIC_CUSTOM *customCursor;     // first listener not yet past in the current sentence
+   NavIC_CUSTOM *customTerm;       // first listener of the current term
+   NavIC_CUSTOM *customIndex[_NavIC_CUSTOM_SLOTS]; // first listener of each sentence, hashed by tag
+   bool customIndexFull;
    void insertCustom(NavIC_CUSTOM *pElt, const char *sentenceName, int index);
+   void indexCustoms();
+   NavIC_CUSTOM *findCustoms(uint64_t tag) const;
+
+   // fix listener support
+   friend class NavIC_LISTENER;
+   NavIC_LISTENER *listeners;
+   uint8_t lastCommitFields;
+   void notifyListeners();
+   void mergeCommitted(NavIC_fix &fix) const;
+#if _NavIC_TALKER_FIXES
+   NavIC_fix talkerFixes[NAVIC_TALKER_OTHER + 1];
+#endif
 
    // statistics
    uint32_t encodedCharCount;
    uint32_t sentencesWithFixCount;
    uint32_t failedChecksumCount;
    uint32_t passedChecksumCount;
+#if _NavIC_STATS
+   NavIC_stats statistics;
+   uint32_t sentenceStart; // navic_cycles() at the '$'
+   bool sentenceOpen;      // started and not yet at its checksum
+   uint64_t timedStages() const;
+   void chargeFraming(uint32_t &mark, uint64_t &stagesMark);
+#endif
 
    // internal utilities
-   int fromHex(char a);
+   friend class navic_stream_pool;
+   template <uint8_t Fields>
+   friend class navic_parser;
+   static int fromHex(char a);
+   static uint64_t sentenceTag(const char *term);
+   static uint8_t sentenceTypeOf(uint64_t tag, uint8_t &talker);
+   void beginSentence();
+   bool skipRepeat(const char *&p, const char *end);
+   void beginTerm();
+   void addTermByte(char c);
+   void addTerm(const char *p, size_t len, const char *end);
+   void materializeCustoms();
+   const NavIC_number &termAsNumber(uint8_t places);
+   bool endOfTerm(char c);
    bool endOfTermHandler();
+   struct FixDecoder;
 };
 
+#define _NavIC_FIX_TERM(sentence_type, term_number) (((unsigned)(sentence_type) << 5) | (term_number))
+
+// Hands term termNumber of an RMC or GGA sentence to the method of decoder
+// for the field it carries.  Every RMC/GGA decoder goes through here, so
+// the term layout lives in one place.  Decoder has head(), the first
+// character of the term, and time(), hasFix(bool), latitude(), south(bool),
+// longitude(), west(bool), speed(), course(), date(), satellites(),
+// hdop() and altitude(), which read the term the way it holds it.
+template <class Decoder>
+inline void navic_fix_term(uint8_t sentenceType, uint8_t termNumber, Decoder &decoder)
+{
+   switch (_NavIC_FIX_TERM(sentenceType, termNumber))
+   {
+   case _NavIC_FIX_TERM(navic_gn_rmc_gga::NAVIC_SENTENCE_RMC, 1): // Time in both sentences
+   case _NavIC_FIX_TERM(navic_gn_rmc_gga::NAVIC_SENTENCE_GGA, 1):
+      decoder.time();
+      break;
+   case _NavIC_FIX_TERM(navic_gn_rmc_gga::NAVIC_SENTENCE_RMC, 2): // RMC validity
+      decoder.hasFix(decoder.head() == 'A');
+      break;
+   case _NavIC_FIX_TERM(navic_gn_rmc_gga::NAVIC_SENTENCE_RMC, 3): // Latitude
+   case _NavIC_FIX_TERM(navic_gn_rmc_gga::NAVIC_SENTENCE_GGA, 2):
+      decoder.latitude();
+      break;
+   case _NavIC_FIX_TERM(navic_gn_rmc_gga::NAVIC_SENTENCE_RMC, 4): // N/S
+   case _NavIC_FIX_TERM(navic_gn_rmc_gga::NAVIC_SENTENCE_GGA, 3):
+      decoder.south(decoder.head() == 'S');
+      break;
+   case _NavIC_FIX_TERM(navic_gn_rmc_gga::NAVIC_SENTENCE_RMC, 5): // Longitude
+   case _NavIC_FIX_TERM(navic_gn_rmc_gga::NAVIC_SENTENCE_GGA, 4):
+      decoder.longitude();
+      break;
+   case _NavIC_FIX_TERM(navic_gn_rmc_gga::NAVIC_SENTENCE_RMC, 6): // E/W
+   case _NavIC_FIX_TERM(navic_gn_rmc_gga::NAVIC_SENTENCE_GGA, 5):
+      decoder.west(decoder.head() == 'W');
+      break;
+   case _NavIC_FIX_TERM(navic_gn_rmc_gga::NAVIC_SENTENCE_RMC, 7): // Speed (RMC)
+      decoder.speed();
+      break;
+   case _NavIC_FIX_TERM(navic_gn_rmc_gga::NAVIC_SENTENCE_RMC, 8): // Course (RMC)
+      decoder.course();
+      break;
+   case _NavIC_FIX_TERM(navic_gn_rmc_gga::NAVIC_SENTENCE_RMC, 9): // Date (RMC)
+      decoder.date();
+      break;
+   case _NavIC_FIX_TERM(navic_gn_rmc_gga::NAVIC_SENTENCE_GGA, 6): // Fix data (GGA)
+      decoder.hasFix(decoder.head() > '0');
+      break;
+   case _NavIC_FIX_TERM(navic_gn_rmc_gga::NAVIC_SENTENCE_GGA, 7): // Satellites used (GGA)
+      decoder.satellites();
+      break;
+   case _NavIC_FIX_TERM(navic_gn_rmc_gga::NAVIC_SENTENCE_GGA, 8): // HDOP
+      decoder.hdop();
+      break;
+   case _NavIC_FIX_TERM(navic_gn_rmc_gga::NAVIC_SENTENCE_GGA, 9): // Altitude (GGA)
+      decoder.altitude();
+      break;
+   }
+}
+
 #endif // def(__navic_gn_rmc_gga_h)
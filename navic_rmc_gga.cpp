@@ -18,21 +18,45 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
-#include "navic_rmc_gga++.cpp"
+#include "navic_rmc_gga++.h"
+#include "navic_scan.h"
+#include "navic_checksum.h"
+#include "navic_digits.h"
+#include "navic_dedup.h"
 
 #include <string.h>
-#include <ctype.h>
 #include <stdlib.h>
 
-// #define _GNRMCterm "GNRMC"
-// #define _GNGGAterm "GNGGA"
-#define _GNRMCterm "GNRMC"
-#define _GNGGAterm "GNGGA"
+#define _RMCtag _NavIC_TAG3('R', 'M', 'C')
+#define _GGAtag _NavIC_TAG3('G', 'G', 'A')
+#define _GSVtag _NavIC_TAG3('G', 'S', 'V')
+#define _GSAtag _NavIC_TAG3('G', 'S', 'A')
 
 navic_gn_rmc_gga::navic_gn_rmc_gga()
-    : parity(0), isChecksumTerm(false), curSentenceType(NAVIC_SENTENCE_OTHER), curTermNumber(0), curTermOffset(0), sentenceHasFix(false), customElts(0), customCandidates(0), encodedCharCount(0), sentencesWithFixCount(0), failedChecksumCount(0), passedChecksumCount(0)
+    : parity(0), isChecksumTerm(false), curSentenceType(NAVIC_SENTENCE_OTHER), curTalker(NAVIC_TALKER_OTHER), lastSentenceType(NAVIC_SENTENCE_OTHER), lastTalker(NAVIC_TALKER_OTHER), curTermNumber(0), curTermOffset(0), sentenceHasFix(false), sentenceCache(0), customElts(0), customCandidates(0), customCursor(0), customTerm(0), customIndexFull(false), listeners(0), lastCommitFields(0), encodedCharCount(0), sentencesWithFixCount(0), failedChecksumCount(0), passedChecksumCount(0)
 {
-  term[0] = '\0';
+  memset(customIndex, 0, sizeof(customIndex));
+#if _NavIC_STATS
+  resetStats();
+  sentenceOpen = false;
+#endif
+  beginSentence();
+#if _NavIC_STATS
+  sentenceOpen = false;
+#endif
+}
+
+// Listeners that outlive the parser must not reach back into it.  A copy
+// of the parser shares the list but not the listeners, so stop at the
+// first that is not this one's.
+navic_gn_rmc_gga::~navic_gn_rmc_gga()
+{
+  for (NavIC_LISTENER *p = listeners, *next; p != NULL && p->navic == this; p = next)
+  {
+    next = p->next;
+    p->navic = NULL;
+    p->next = NULL;
+  }
 }
 
 //
@@ -50,31 +74,14 @@ bool navic_gn_rmc_gga::encode(char c)
   case '\r':
   case '\n':
   case '*':
-  {
-    bool isValidSentence = false;
-    if (curTermOffset < sizeof(term))
-    {
-      term[curTermOffset] = 0;
-      isValidSentence = endOfTermHandler();
-    }
-    ++curTermNumber;
-    curTermOffset = 0;
-    isChecksumTerm = c == '*';
-    return isValidSentence;
-  }
-  break;
+    return endOfTerm(c);
 
   case '$': // sentence begin
-    curTermNumber = curTermOffset = 0;
-    parity = 0;
-    curSentenceType = NAVIC_SENTENCE_OTHER;
-    isChecksumTerm = false;
-    sentenceHasFix = false;
+    beginSentence();
     return false;
 
   default: // ordinary characters
-    if (curTermOffset < sizeof(term) - 1)
-      term[curTermOffset++] = c;
+    addTermByte(c);
     if (!isChecksumTerm)
       parity ^= c;
     return false;
@@ -83,9 +90,279 @@ bool navic_gn_rmc_gga::encode(char c)
   return false;
 }
 
+size_t navic_gn_rmc_gga::encode(const char *buf, size_t len)
+{
+  size_t validSentences = 0;
+  const char *end = buf + len;
+  encodedCharCount += len;
+#if _NavIC_STATS
+  uint32_t mark = navic_cycles();
+  uint64_t stagesMark = timedStages();
+#endif
+
+  while (buf < end)
+  {
+#if _NavIC_STATS
+    chargeFraming(mark, stagesMark);
+#endif
+    // Nothing listens to the terms of an unrecognised sentence, so its
+    // body is only folded into the parity, commas included
+    bool skipping = !isChecksumTerm && curSentenceType == NAVIC_SENTENCE_OTHER && curTermNumber > 0 && customCandidates == NULL;
+    size_t run;
+    if (isChecksumTerm)
+      run = navic_scan<true, false>(buf, end - buf, parity);
+    else if (skipping)
+      run = navic_scan<false, true>(buf, end - buf, parity);
+    else
+      run = navic_scan<true, true>(buf, end - buf, parity);
+
+    // A term that lies wholly in buf is parsed where it is; one that
+    // straddles two calls is accumulated byte by byte
+    if (!skipping)
+    {
+      if (curTermOffset == 0 && run < (size_t)(end - buf))
+        addTerm(buf, run, end);
+      else
+        for (size_t i = 0; i < run; ++i)
+          addTermByte(buf[i]);
+    }
+    buf += run;
+
+    if (buf == end)
+      break;
+
+    char c = *buf++;
+    if (c == '$')
+    {
+      beginSentence();
+      if (sentenceCache != NULL && skipRepeat(buf, end))
+        continue;
+    }
+    else
+    {
+      if (c == ',')
+        parity ^= (uint8_t)c;
+      if (endOfTerm(c))
+        ++validSentences;
+    }
+  }
+
+  // custom values may still refer to terms in buf
+  materializeCustoms();
+#if _NavIC_STATS
+  chargeFraming(mark, stagesMark);
+#endif
+  return validSentences;
+}
+
+#if _NavIC_STATS
+uint64_t navic_gn_rmc_gga::timedStages() const
+{
+  return statistics.cycles[NavIC_stats::STAGE_LOOKUP] + statistics.cycles[NavIC_stats::STAGE_FIELDS] + statistics.cycles[NavIC_stats::STAGE_COMMIT];
+}
+
+// Charges the time since mark, less the stages timed within it, to
+// framing.  Called once per scan run, so the interval stays well inside
+// the 32 bits of navic_cycles() however long the buffer is.
+void navic_gn_rmc_gga::chargeFraming(uint32_t &mark, uint64_t &stagesMark)
+{
+  uint32_t now = navic_cycles();
+  uint64_t stages = timedStages();
+  uint32_t elapsed = now - mark;
+  if (elapsed > stages - stagesMark)
+    statistics.cycles[NavIC_stats::STAGE_FRAMING] += elapsed - (stages - stagesMark);
+  mark = now;
+  stagesMark = stages;
+}
+#endif
+
+// Frames and checks whole sentences without decoding any fields; only
+// passedChecksum()/failedChecksum() are updated
+size_t navic_gn_rmc_gga::validateChecksums(const char *buf, size_t len)
+{
+  return navic_validate_checksums(buf, len, passedChecksumCount, failedChecksumCount);
+}
+
 //
 // internal utilities
 //
+void navic_gn_rmc_gga::beginSentence()
+{
+#if _NavIC_STATS
+  if (sentenceOpen)
+    ++statistics.truncated;
+  sentenceOpen = true;
+  sentenceStart = navic_cycles();
+#endif
+  materializeCustoms();
+  curTermNumber = 0;
+  parity = 0;
+  curSentenceType = NAVIC_SENTENCE_OTHER;
+  isChecksumTerm = false;
+  sentenceHasFix = false;
+  curTag = 0;
+  beginTerm();
+}
+
+// After the '$' at p - 1: if the sentence ends within the buffer and is a
+// repeat, moves p past its '\n' and leaves the parser as after a sentence
+// nobody reads, so stray bytes up to the next '$' are skipped too.  Parts
+// of a multi-part GSV are never skipped: a part repeated after a changed
+// one still has to complete the sequence.
+bool navic_gn_rmc_gga::skipRepeat(const char *&p, const char *end)
+{
+  const char *nl = (const char *)memchr(p, '\n', end - p);
+  if (nl == NULL || memchr(p, '$', nl - p) != NULL)
+    return false;
+  if (nl - p >= 8 && memcmp(p + 2, "GSV,", 4) == 0 && (p[6] != '1' || p[7] != ','))
+    return false;
+  if (!sentenceCache->repeat(p - 1, nl + 1 - (p - 1)))
+    return false;
+  curTermNumber = 1;
+  customCandidates = customCursor = NULL;
+#if _NavIC_STATS
+  sentenceOpen = false;
+#endif
+  p = nl + 1;
+  return true;
+}
+
+// Terms read as numbers, by sentence type; bit n for term n, and bit 31
+// for all terms from 31 on
+static const uint32_t numericTerms[] = {
+    0x396, // GGA: time, latitude, longitude, satellites, HDOP, altitude
+    0x3AA, // RMC: time, latitude, longitude, speed, course, date
+    0xFFFFFFFE, // GSV
+    0xFFFFFFFE, // GSA
+    0};
+
+void navic_gn_rmc_gga::beginTerm()
+{
+  curTermOffset = 0;
+  termHead[0] = termHead[1] = termHead[2] = 0;
+#if _NavIC_INCREMENTAL_TERMS
+  termValue.reset();
+#endif
+  termStart = NULL;
+  termIsNumber = !isChecksumTerm && (numericTerms[curSentenceType] >> (curTermNumber < 31 ? curTermNumber : 31) & 1);
+
+  // candidates are sorted by term number, so the cursor only ever moves
+  // forward through the sentence
+  customTerm = NULL;
+  if (curTermNumber == 0)
+    return;
+  for (; customCursor != NULL && customCursor->tag == customCandidates->tag && customCursor->termNumber < curTermNumber; customCursor = customCursor->next)
+    ;
+  if (customCursor != NULL && customCursor->tag == customCandidates->tag && customCursor->termNumber == curTermNumber && !isChecksumTerm)
+    customTerm = customCursor;
+}
+
+// Feeds one character of the current term to whatever consumes it
+void navic_gn_rmc_gga::addTermByte(char c)
+{
+  if (curTermOffset < 2)
+    termHead[curTermOffset] = c;
+  if (curTermNumber == 0)
+    curTag = curTermOffset < 8 ? curTag | (uint64_t)(uint8_t)c << (8 * curTermOffset) : 0;
+#if _NavIC_INCREMENTAL_TERMS
+  else if (termIsNumber)
+    termValue.add(c);
+#else
+  if (curTermOffset < _NavIC_MAX_FIELD_SIZE - 1)
+    term[curTermOffset] = c;
+#endif
+  if (customTerm != NULL && curTermOffset < _NavIC_MAX_FIELD_SIZE - 1)
+    customTerm->stagingBuffer[curTermOffset] = c;
+  if (curTermOffset < UCHAR_MAX)
+    ++curTermOffset;
+}
+
+// The whole current term at p, followed by a delimiter and more of the
+// buffer up to end; it is read where it is when it ends, by the fields
+// that need it, and custom listeners refer to it there rather than to a
+// copy
+void navic_gn_rmc_gga::addTerm(const char *p, size_t len, const char *end)
+{
+  curTermOffset = len < UCHAR_MAX ? len : UCHAR_MAX;
+  termHead[0] = len > 0 ? p[0] : 0;
+  termHead[1] = len > 1 ? p[1] : 0;
+  if (curTermNumber == 0)
+  {
+    for (size_t i = 0; i < len && i < 8; ++i)
+      curTag |= (uint64_t)(uint8_t)p[i] << (8 * i);
+    if (len > 8)
+      curTag = 0;
+  }
+  termStart = p;
+  termPadded = end - (p + len) >= 8;
+}
+
+// Copies custom values that still refer to a caller's buffer
+void navic_gn_rmc_gga::materializeCustoms()
+{
+  for (NavIC_CUSTOM *p = customCandidates; p != NULL && p->tag == customCandidates->tag; p = p->next)
+    p->materialize();
+}
+
+// The current term as a number with at least places fraction digits
+const NavIC_number &navic_gn_rmc_gga::termAsNumber(uint8_t places)
+{
+  if (termStart == NULL)
+  {
+#if _NavIC_INCREMENTAL_TERMS
+    termValue.finish();
+#else
+    // fed byte by byte, so copied: longer terms are cut at
+    // _NavIC_MAX_FIELD_SIZE - 1 characters
+    term[curTermOffset < _NavIC_MAX_FIELD_SIZE - 1 ? curTermOffset : _NavIC_MAX_FIELD_SIZE - 1] = 0;
+    navic_parse_number<_NavIC_TERM_PADDED>(term, termValue, places);
+#endif
+  }
+  else if (termPadded)
+    navic_parse_number<true>(termStart, termValue, places);
+  else
+    navic_parse_number<false>(termStart, termValue, places);
+  return termValue;
+}
+
+bool navic_gn_rmc_gga::endOfTerm(char c)
+{
+#if _NavIC_STATS
+  // the bulk encode() skips the terms of sentences nobody reads, so only
+  // the others are measured
+  if (curTermOffset > _NavIC_MAX_FIELD_SIZE - 1 && (curTermNumber == 0 || curSentenceType != NAVIC_SENTENCE_OTHER || customCandidates != NULL))
+    ++statistics.termOverflows;
+  uint8_t stage = isChecksumTerm ? NavIC_stats::STAGE_COMMIT : curTermNumber == 0 ? NavIC_stats::STAGE_LOOKUP : NavIC_stats::STAGE_FIELDS;
+  uint8_t type = curSentenceType;
+  uint32_t start = navic_cycles();
+#endif
+  bool isValidSentence = endOfTermHandler();
+#if _NavIC_STATS
+  uint32_t now = navic_cycles();
+  statistics.cycles[stage] += (uint32_t)(now - start);
+  if (isChecksumTerm)
+  {
+    sentenceOpen = false;
+    if (isValidSentence)
+    {
+      ++statistics.passed[type];
+      uint32_t ticks = now - sentenceStart;
+      uint8_t bucket = 0;
+      for (; ticks > 1 && bucket < _NavIC_LATENCY_BUCKETS - 1; ticks >>= 1)
+        ++bucket;
+      ++statistics.latency[bucket];
+    }
+    else
+      ++statistics.failed[type];
+  }
+#endif
+  if (curTermNumber < 255)
+    ++curTermNumber;
+  isChecksumTerm = c == '*';
+  beginTerm();
+  return isValidSentence;
+}
+
 int navic_gn_rmc_gga::fromHex(char a)
 {
   if (a >= 'A' && a <= 'F')
@@ -97,50 +374,104 @@ int navic_gn_rmc_gga::fromHex(char a)
 }
 
 // static
-// Parse a (potentially negative) number with up to 2 decimal digits -xxxx.yy
-int32_t navic_gn_rmc_gga::parseDecimal(const char *term)
+// Pack a sentence name into an integer; 0 if it is longer than 8 characters
+uint64_t navic_gn_rmc_gga::sentenceTag(const char *term)
 {
-  bool negative = *term == '-';
-  if (negative)
-    ++term;
-  int32_t ret = 100 * (int32_t)atol(term);
-  while (isdigit(*term))
-    ++term;
-  if (*term == '.' && isdigit(term[1]))
+  uint64_t tag = 0;
+  for (unsigned shift = 0; *term; shift += 8, ++term)
   {
-    ret += 10 * (term[1] - '0');
-    if (isdigit(term[2]))
-      ret += term[2] - '0';
+    if (shift == 64)
+      return 0;
+    tag |= (uint64_t)(uint8_t)*term << shift;
   }
-  return negative ? -ret : ret;
+  return tag;
 }
 
 // static
-// Parse degrees in that funny NMEA format DDMM.MMMM
-void navic_gn_rmc_gga::parseDegrees(const char *term, RawDegrees &deg)
+// Split a standard TTSSS name into talker and sentence type; both decode
+// to _OTHER for proprietary or otherwise unknown names
+uint8_t navic_gn_rmc_gga::sentenceTypeOf(uint64_t tag, uint8_t &talker)
 {
-  uint32_t leftOfDecimal = (uint32_t)atol(term);
-  uint16_t minutes = (uint16_t)(leftOfDecimal % 100);
-  uint32_t multiplier = 10000000UL;
-  uint32_t tenMillionthsOfMinutes = minutes * multiplier;
+  talker = NAVIC_TALKER_OTHER;
+  if ((tag >> 32) == 0 || (tag >> 40) != 0)
+    return NAVIC_SENTENCE_OTHER;
 
-  deg.deg = (int16_t)(leftOfDecimal / 100);
+  switch ((uint16_t)tag)
+  {
+  case _NavIC_TAG2('G', 'P'):
+    talker = NAVIC_TALKER_GP;
+    break;
+  case _NavIC_TAG2('G', 'L'):
+    talker = NAVIC_TALKER_GL;
+    break;
+  case _NavIC_TAG2('G', 'A'):
+    talker = NAVIC_TALKER_GA;
+    break;
+  case _NavIC_TAG2('G', 'B'):
+  case _NavIC_TAG2('B', 'D'):
+    talker = NAVIC_TALKER_GB;
+    break;
+  case _NavIC_TAG2('G', 'I'):
+    talker = NAVIC_TALKER_GI;
+    break;
+  case _NavIC_TAG2('G', 'Q'):
+    talker = NAVIC_TALKER_GQ;
+    break;
+  case _NavIC_TAG2('G', 'N'):
+    talker = NAVIC_TALKER_GN;
+    break;
+  default:
+    return NAVIC_SENTENCE_OTHER;
+  }
 
-  while (isdigit(*term))
-    ++term;
+  switch ((uint32_t)(tag >> 16))
+  {
+  case _RMCtag:
+    return NAVIC_SENTENCE_RMC;
+  case _GGAtag:
+    return NAVIC_SENTENCE_GGA;
+  case _GSVtag:
+    return NAVIC_SENTENCE_GSV;
+  case _GSAtag:
+    return NAVIC_SENTENCE_GSA;
+  default:
+    return NAVIC_SENTENCE_OTHER;
+  }
+}
 
-  if (*term == '.')
-    while (isdigit(*++term))
-    {
-      multiplier /= 10;
-      tenMillionthsOfMinutes += (*term - '0') * multiplier;
-    }
+// static
+// Parse a (potentially negative) number -xxxx.yy, scaled by 10^places
+int32_t navic_gn_rmc_gga::parseDecimal(const char *term, uint8_t places)
+{
+  return navic_parse_decimal<false>(term, places);
+}
 
-  deg.billionths = (5 * tenMillionthsOfMinutes + 1) / 3;
-  deg.negative = false;
+// static
+// Parse degrees in that funny NMEA format DDMM.MMMM
+void navic_gn_rmc_gga::parseDegrees(const char *term, RawDegrees &deg)
+{
+  navic_parse_degrees<false>(term, deg);
 }
 
-#define COMBINE(sentence_type, term_number) (((unsigned)(sentence_type) << 5) | term_number)
+// The RMC/GGA fields, as navic_fix_term() hands them over
+struct navic_gn_rmc_gga::FixDecoder
+{
+  navic_gn_rmc_gga &navic;
+
+  char head() const { return navic.termHead[0]; }
+  void time() { navic.time.setTime(navic.termAsNumber(2)); }
+  void hasFix(bool fix) { navic.sentenceHasFix = fix; }
+  void latitude() { navic.location.setLatitude(navic.termAsNumber(7)); }
+  void south(bool south) { navic.location.rawNewLatData.negative = south; }
+  void longitude() { navic.location.setLongitude(navic.termAsNumber(7)); }
+  void west(bool west) { navic.location.rawNewLngData.negative = west; }
+  void speed() { navic.speed.set(navic.termAsNumber(2)); }
+  void course() { navic.course.set(navic.termAsNumber(2)); }
+  void date() { navic.date.setDate(navic.termAsNumber(0)); }
+  void satellites() { navic.satellites.set(navic.termAsNumber(0)); }
+  void hdop() { navic.hdop.set(navic.termAsNumber(2)); }
+  void altitude() { navic.altitude.set(navic.termAsNumber(2)); }
+};
 
 // Processes a just-completed term
 // Returns true if new sentence has just passed checksum test and is validated
@@ -149,42 +480,64 @@ bool navic_gn_rmc_gga::endOfTermHandler()
   // If it's the checksum term, and the checksum checks out, commit
   if (isChecksumTerm)
   {
-    byte checksum = 16 * fromHex(term[0]) + fromHex(term[1]);
+    byte checksum = 16 * fromHex(termHead[0]) + fromHex(termHead[1]);
     if (checksum == parity)
     {
       passedChecksumCount++;
       if (sentenceHasFix)
         ++sentencesWithFixCount;
+      lastSentenceType = curSentenceType;
+      lastTalker = curTalker;
 
       switch (curSentenceType)
       {
-      case NAVIC_SENTENCE_GNRMC:
+      case NAVIC_SENTENCE_RMC:
         date.commit();
         time.commit();
+        lastCommitFields = NavIC_fix::DATE | NavIC_fix::TIME;
         if (sentenceHasFix)
         {
           location.commit();
           speed.commit();
           course.commit();
+          lastCommitFields |= NavIC_fix::LOCATION | NavIC_fix::SPEED | NavIC_fix::COURSE;
         }
         break;
-      case NAVIC_SENTENCE_GNGGA:
+      case NAVIC_SENTENCE_GGA:
         time.commit();
+        lastCommitFields = NavIC_fix::TIME | NavIC_fix::SATELLITES | NavIC_fix::HDOP;
         if (sentenceHasFix)
         {
           location.commit();
           altitude.commit();
+          lastCommitFields |= NavIC_fix::LOCATION | NavIC_fix::ALTITUDE;
         }
         satellites.commit();
         hdop.commit();
         break;
+      case NAVIC_SENTENCE_GSV:
+        satellitesInView.commit(curTermNumber);
+        lastCommitFields = 0;
+        break;
+      case NAVIC_SENTENCE_GSA:
+        activeSatellites.commit();
+        lastCommitFields = 0;
+        break;
+      default:
+        lastCommitFields = 0;
+        break;
       }
 
       // Commit all custom listeners of this sentence type
-      for (navic_rmc_gga
-               Custom *p = customCandidates;
-           p != NULL && strcmp(p->sentenceName, customCandidates->sentenceName) == 0; p = p->next)
+      for (NavIC_CUSTOM *p = customCandidates; p != NULL && p->tag == customCandidates->tag; p = p->next)
         p->commit();
+
+#if _NavIC_TALKER_FIXES
+      if (lastCommitFields)
+        mergeCommitted(talkerFixes[curTalker]);
+#endif
+      if (listeners != NULL)
+        notifyListeners();
       return true;
     }
 
@@ -199,81 +552,100 @@ bool navic_gn_rmc_gga::endOfTermHandler()
   // the first term determines the sentence type
   if (curTermNumber == 0)
   {
-    if (!strcmp(term, _GNRMCterm))
-      curSentenceType = NavIC_SENTENCE_GNRMC;
-    else if (!strcmp(term, _GNGGAterm))
-      curSentenceType = NavIC_SENTENCE_GNGGA;
-    else
-      curSentenceType = NAVIC_SENTENCE_OTHER;
+    curSentenceType = sentenceTypeOf(curTag, curTalker);
 
     // Any custom candidates of this sentence type?
-    for (customCandidates = customElts; customCandidates != NULL && strcmp(customCandidates->sentenceName, term) < 0; customCandidates = customCandidates->next)
-      ;
-    if (customCandidates != NULL && strcmp(customCandidates->sentenceName, term) > 0)
-      customCandidates = NULL;
+    customCandidates = customCursor = customElts != NULL ? findCustoms(curTag) : NULL;
 
     return false;
   }
 
-  if (curSentenceType != NAVIC_SENTENCE_OTHER && term[0])
-    switch (COMBINE(curSentenceType, curTermNumber))
+  // Satellite tables take empty terms too
+  if (curSentenceType == NAVIC_SENTENCE_GSV)
+    satellitesInView.setTerm(curTalker, curTermNumber, termAsNumber(0));
+  else if (curSentenceType == NAVIC_SENTENCE_GSA)
+    activeSatellites.setTerm(curTalker, curTermNumber, termAsNumber(2), termHead);
+  else if (curSentenceType != NAVIC_SENTENCE_OTHER && curTermOffset != 0)
+  {
+    FixDecoder decoder = {*this};
+    navic_fix_term(curSentenceType, curTermNumber, decoder);
+  }
+
+  // Stage custom values, as read into stagingBuffer or in place; further
+  // listeners of the same term share the first one's value
+  if (customTerm != NULL)
+  {
+    const char *staged = termStart != NULL ? termStart : customTerm->stagingBuffer;
+    uint8_t length = curTermOffset < _NavIC_MAX_FIELD_SIZE - 1 ? curTermOffset : _NavIC_MAX_FIELD_SIZE - 1;
+    for (NavIC_CUSTOM *p = customTerm; p != NULL && p->tag == customTerm->tag && p->termNumber == curTermNumber; p = p->next)
     {
-    case COMBINE(NAVIC_SENTENCE_GNRMC, 1): // Time in both sentences
-    case COMBINE(NAVIC_SENTENCE_GNGGA, 1):
-      time.setTime(term);
-      break;
-    case COMBINE(NAVIC_SENTENCE_GNRMC, 2): // GNRMC validity
-      sentenceHasFix = term[0] == 'A';
-      break;
-    case COMBINE(NAVIC_SENTENCE_GNRMC, 3): // Latitude
-    case COMBINE(NAVIC_SENTENCE_GNGGA, 2):
-      location.setLatitude(term);
-      break;
-    case COMBINE(NAVIC_SENTENCE_GNRMC, 4): // N/S
-    case COMBINE(NAVIC_SENTENCE_GNGGA, 3):
-      location.rawNewLatData.negative = term[0] == 'S';
-      break;
-    case COMBINE(NAVIC_SENTENCE_GNRMC, 5): // Longitude
-    case COMBINE(NAVIC_SENTENCE_GNGGA, 4):
-      location.setLongitude(term);
-      break;
-    case COMBINE(NAVIC_SENTENCE_GNRMC, 6): // E/W
-    case COMBINE(NAVIC_SENTENCE_GNGGA, 5):
-      location.rawNewLngData.negative = term[0] == 'W';
-      break;
-    case COMBINE(NAVIC_SENTENCE_GNRMC, 7): // Speed (GNRMC)
-      speed.set(term);
-      break;
-    case COMBINE(NAVIC_SENTENCE_GNRMC, 8): // Course (GNRMC)
-      course.set(term);
-      break;
-    case COMBINE(NAVIC_SENTENCE_GNRMC, 9): // Date (GNRMC)
-      date.setDate(term);
-      break;
-    case COMBINE(NAVIC_SENTENCE_GNGGA, 6): // Fix data (GNGGA)
-      sentenceHasFix = term[0] > '0';
-      break;
-    case COMBINE(NAVIC_SENTENCE_GNGGA, 7): // Satellites used (GNGGA)
-      satellites.set(term);
-      break;
-    case COMBINE(NAVIC_SENTENCE_GNGGA, 8): // HDOP
-      hdop.set(term);
-      break;
-    case COMBINE(NAVIC_SENTENCE_GNGGA, 9): // Altitude (GNGGA)
-      altitude.set(term);
-      break;
+      p->staged = staged;
+      p->stagedLength = length;
     }
-
-  // Set custom values as needed
-  for (navic_rmc_gga
-           Custom *p = customCandidates;
-       p != NULL && strcmp(p->sentenceName, customCandidates->sentenceName) == 0 && p->termNumber <= curTermNumber; p = p->next)
-    if (p->termNumber == curTermNumber)
-      p->set(term);
+  }
 
   return false;
 }
 
+#if _NavIC_STATS
+void navic_gn_rmc_gga::resetStats()
+{
+  memset(&statistics, 0, sizeof(statistics));
+}
+#endif
+
+void navic_gn_rmc_gga::snapshot(NavIC_fix &fix) const
+{
+  fix.lat = location.rawLatData;
+  fix.lng = location.rawLngData;
+  fix.date = date.date;
+  fix.time = time.time;
+  fix.speed = speed.val;
+  fix.course = course.val;
+  fix.altitude = altitude.val;
+  fix.satellites = satellites.val;
+  fix.hdop = hdop.val;
+  fix.sentence = lastSentenceType;
+  fix.talker = lastTalker;
+  fix.committed = lastCommitFields;
+  fix.fields = (location.valid ? NavIC_fix::LOCATION : 0) |
+               (date.valid ? NavIC_fix::DATE : 0) |
+               (time.valid ? NavIC_fix::TIME : 0) |
+               (speed.valid ? NavIC_fix::SPEED : 0) |
+               (course.valid ? NavIC_fix::COURSE : 0) |
+               (altitude.valid ? NavIC_fix::ALTITUDE : 0) |
+               (satellites.valid ? NavIC_fix::SATELLITES : 0) |
+               (hdop.valid ? NavIC_fix::HDOP : 0);
+}
+
+// Copy only what the last sentence committed into fix
+void navic_gn_rmc_gga::mergeCommitted(NavIC_fix &fix) const
+{
+  if (lastCommitFields & NavIC_fix::LOCATION)
+  {
+    fix.lat = location.rawLatData;
+    fix.lng = location.rawLngData;
+  }
+  if (lastCommitFields & NavIC_fix::DATE)
+    fix.date = date.date;
+  if (lastCommitFields & NavIC_fix::TIME)
+    fix.time = time.time;
+  if (lastCommitFields & NavIC_fix::SPEED)
+    fix.speed = speed.val;
+  if (lastCommitFields & NavIC_fix::COURSE)
+    fix.course = course.val;
+  if (lastCommitFields & NavIC_fix::ALTITUDE)
+    fix.altitude = altitude.val;
+  if (lastCommitFields & NavIC_fix::SATELLITES)
+    fix.satellites = satellites.val;
+  if (lastCommitFields & NavIC_fix::HDOP)
+    fix.hdop = hdop.val;
+  fix.sentence = lastSentenceType;
+  fix.talker = lastTalker;
+  fix.fields |= lastCommitFields;
+  fix.committed = lastCommitFields;
+}
+
 /* static */
 double navic_gn_rmc_gga::distanceBetween(double lat1, double long1, double lat2, double long2)
 {
@@ -320,6 +692,193 @@ double navic_gn_rmc_gga::courseTo(double lat1, double long1, double lat2, double
   return degrees(a2);
 }
 
+// cos(n degrees) for n = 0..90, in 1/32768ths
+static const uint16_t cosTable[91] = {
+    32768, 32763, 32748, 32723, 32688, 32643, 32588, 32524, 32449, 32365,
+    32270, 32166, 32052, 31928, 31795, 31651, 31499, 31336, 31164, 30983,
+    30792, 30592, 30382, 30163, 29935, 29698, 29452, 29197, 28932, 28660,
+    28378, 28088, 27789, 27482, 27166, 26842, 26510, 26170, 25822, 25466,
+    25102, 24730, 24351, 23965, 23571, 23170, 22763, 22348, 21926, 21498,
+    21063, 20622, 20174, 19720, 19261, 18795, 18324, 17847, 17364, 16877,
+    16384, 15886, 15384, 14876, 14365, 13848, 13328, 12803, 12275, 11743,
+    11207, 10668, 10126, 9580, 9032, 8481, 7927, 7371, 6813, 6252,
+    5690, 5126, 4560, 3993, 3425, 2856, 2286, 1715, 1144, 572,
+    0};
+
+// cos of a latitude in degrees * 10^7, in 1/32768ths
+static uint32_t cosE7(int32_t lat)
+{
+  uint32_t a = lat < 0 ? -(uint32_t)lat : (uint32_t)lat;
+  uint32_t whole = a / 10000000;
+  if (whole >= 90)
+    return 0;
+  uint32_t step = cosTable[whole] - cosTable[whole + 1];
+  return cosTable[whole] - step * (a % 10000000 / 1000) / 10000;
+}
+
+// sin of an angle of 0 to 180 degrees * 10^7, in 1/32768ths
+static uint32_t sinE7(uint32_t angle)
+{
+  return cosE7(900000000 - (int32_t)angle);
+}
+
+// sin of -180 to 180 degrees * 10^7 in 1/2^30ths, from its series, which
+// unlike the table keeps its precision for small angles
+static int32_t sinFineE7(int32_t angle)
+{
+  uint32_t a = angle < 0 ? -(uint32_t)angle : (uint32_t)angle;
+  if (a > 900000000)
+    a = 1800000000 - a;
+  const int64_t one = (int64_t)1 << 30;
+  int64_t x = (int64_t)((uint64_t)a * 1874033 / 1000000); // radians in 1/2^30ths
+  int64_t x2 = x * x >> 30;
+  int64_t s = one - x2 / 110;
+  s = one - (x2 * s >> 30) / 72;
+  s = one - (x2 * s >> 30) / 42;
+  s = one - (x2 * s >> 30) / 20;
+  s = one - (x2 * s >> 30) / 6;
+  int32_t ret = (int32_t)(x * s >> 30);
+  return angle < 0 ? -ret : ret;
+}
+
+static uint32_t isqrt64(uint64_t n)
+{
+  uint64_t root = 0;
+  uint64_t bit = (uint64_t)1 << 62;
+  while (bit > n)
+    bit >>= 2;
+  while (bit != 0)
+  {
+    if (n >= root + bit)
+    {
+      n -= root + bit;
+      root = (root >> 1) + bit;
+    }
+    else
+      root >>= 1;
+    bit >>= 2;
+  }
+  return (uint32_t)root;
+}
+
+// Pairs whose mean latitude is within 10 degrees of a pole are taken along
+// the great circle
+static bool polarE7(int32_t mean)
+{
+  return mean > 800000000 || mean < -800000000;
+}
+
+// Longitude of position 2 less that of position 1 the short way round, and
+// 0 to or from a pole, which has none
+static int32_t dlongE7(int32_t lat1, int32_t long1, int32_t lat2, int32_t long2)
+{
+  if (lat1 == 900000000 || lat1 == -900000000 || lat2 == 900000000 || lat2 == -900000000)
+    return 0;
+  int64_t dlong = (int64_t)long2 - long1;
+  if (dlong > 1800000000)
+    dlong -= 3600000000LL;
+  else if (dlong < -1800000000)
+    dlong += 3600000000LL;
+  return (int32_t)dlong;
+}
+
+// North and east offsets of position 2 from position 1 in degrees * 10^7
+// of arc, east negative for west
+static void offsetE7(int32_t lat1, int32_t long1, int32_t lat2, int32_t long2, int32_t &north, int32_t &east)
+{
+  int32_t dlong = dlongE7(lat1, long1, lat2, long2);
+  int32_t mean = lat1 / 2 + lat2 / 2;
+
+  if (polarE7(mean))
+  {
+    // The meridians converge too fast here for a flat approximation; take
+    // sin(d) sin(course) and sin(d) cos(course) of the great circle, in
+    // 1/2^30ths, and scale them to d
+    int64_t s1 = sinFineE7(lat1);
+    int64_t c2 = sinFineE7(900000000 - (lat2 < 0 ? -lat2 : lat2));
+    int64_t half = sinFineE7(dlong / 2);
+    int64_t across = (int64_t)sinFineE7(dlong) * c2 >> 30;
+    int64_t along = sinFineE7(lat2 - lat1) + (((s1 * c2 >> 30) * half >> 30) * half >> 29);
+    uint32_t y = isqrt64((uint64_t)(across * across) + (uint64_t)(along * along));
+    if (y == 0)
+    {
+      north = east = 0;
+      return;
+    }
+    // asin(y), good to a few parts in 10^7 up to 1000 km
+    int64_t y2 = (int64_t)y * y >> 30;
+    int64_t y3 = (int64_t)y * y2 >> 30;
+    int64_t d = y + y3 / 6 + (y3 * y2 >> 30) * 3 / 40;
+    int64_t arc = d * 5336085 / 10000000; // to degrees * 10^7
+    north = (int32_t)(along * arc / y);
+    east = (int32_t)(across * arc / y);
+  }
+  else
+  {
+    // the parallel through the mean latitude
+    uint32_t magnitude = dlong < 0 ? -(uint32_t)dlong : (uint32_t)dlong;
+    north = lat2 - lat1;
+    east = (int32_t)(((uint64_t)magnitude * cosE7(mean) + 16384) >> 15);
+    if (dlong < 0)
+      east = -east;
+  }
+}
+
+/* static */
+uint32_t navic_gn_rmc_gga::distanceBetweenE7(int32_t lat1, int32_t long1, int32_t lat2, int32_t long2)
+{
+  // on the same 6372795 meter sphere as distanceBetween(); 10^-7 degree
+  // of arc is 1.11226 cm
+  int32_t north, east;
+  offsetE7(lat1, long1, lat2, long2, north, east);
+  uint64_t n = north < 0 ? -(int64_t)north : north;
+  uint64_t e = east < 0 ? -(int64_t)east : east;
+  uint32_t arc = isqrt64(n * n + e * e);
+  return (uint32_t)(((uint64_t)arc * 111226 + 50000) / 100000);
+}
+
+/* static */
+uint16_t navic_gn_rmc_gga::courseToE7(int32_t lat1, int32_t long1, int32_t lat2, int32_t long2)
+{
+  int32_t north, east;
+  offsetE7(lat1, long1, lat2, long2, north, east);
+  uint32_t n = north < 0 ? -(uint32_t)north : (uint32_t)north;
+  uint32_t e = east < 0 ? -(uint32_t)east : (uint32_t)east;
+  uint32_t hi = n > e ? n : e;
+  uint32_t lo = n > e ? e : n;
+  if (hi == 0)
+    return 0;
+  while (hi >= 0x10000)
+  {
+    hi >>= 1;
+    lo >>= 1;
+  }
+
+  // atan(z) ~ 45z + z(1 - z)(14.02 + 3.80z) degrees for z in [0, 1], good
+  // to 0.1 degree; z is in 1/32768ths
+  uint32_t z = (lo << 15) / hi;
+  uint32_t t = z * (32768 - z) >> 15;
+  uint32_t a = (4500 * z + t * (1402 + (380 * z >> 15)) + 16384) >> 15;
+
+  uint32_t course = e <= n ? a : 9000 - a; // from the north-south axis
+  if (north < 0)
+    course = 18000 - course;
+  if (east < 0)
+    course = 36000 - course;
+
+  // Away from the poles the great circle leaves position 1 turned poleward
+  // of the straight line by half the convergence of the meridians,
+  // dlong * sin(mean latitude) / 2
+  int32_t mean = lat1 / 2 + lat2 / 2;
+  if (!polarE7(mean))
+  {
+    int64_t turn = (int64_t)dlongE7(lat1, long1, lat2, long2) * sinE7(mean < 0 ? -mean : mean);
+    turn = (turn + (turn < 0 ? -6553600000LL : 6553600000LL) / 2) / 6553600000LL; // to hundredths of a degree
+    course += 36000 - (int32_t)(mean < 0 ? -turn : turn);
+  }
+  return (uint16_t)(course % 36000);
+}
+
 const char *navic_gn_rmc_gga::cardinal(double course)
 {
   static const char *directions[] = {"N", "NNE", "NE", "ENE", "E", "ESE", "SE", "SSE", "S", "SSW", "SW", "WSW", "W", "WNW", "NW", "NNW"};
@@ -327,167 +886,180 @@ const char *navic_gn_rmc_gga::cardinal(double course)
   return directions[direction % 16];
 }
 
-void navic_location::commit()
+void NavIC_Location::commit()
 {
   rawLatData = rawNewLatData;
   rawLngData = rawNewLngData;
-  lastCommitTime = millis();
+  lastCommitTime = navic_millis();
   valid = updated = true;
 }
 
-void navic_location::setLatitude(const char *term)
+void NavIC_Location::setLatitude(const NavIC_number &term)
 {
-  navic_rmc_gga
-      Plus::parseDegrees(term, rawNewLatData);
+  term.toDegrees(rawNewLatData);
 }
 
-void navic_location::setLongitude(const char *term)
+void NavIC_Location::setLongitude(const NavIC_number &term)
 {
-  navic_rmc_gga
-      Plus::parseDegrees(term, rawNewLngData);
+  term.toDegrees(rawNewLngData);
 }
 
-double navic_location::lat()
+double NavIC_Location::lat()
 {
   updated = false;
   double ret = rawLatData.deg + rawLatData.billionths / 1000000000.0;
   return rawLatData.negative ? -ret : ret;
 }
 
-double navic_location::lng()
+double NavIC_Location::lng()
 {
   updated = false;
   double ret = rawLngData.deg + rawLngData.billionths / 1000000000.0;
   return rawLngData.negative ? -ret : ret;
 }
 
-void navic_date::commit()
+void NavIC_date::commit()
 {
   date = newDate;
-  lastCommitTime = millis();
+  lastCommitTime = navic_millis();
   valid = updated = true;
 }
 
-void navic_time::commit()
+void NavIC_time::commit()
 {
   time = newTime;
-  lastCommitTime = millis();
+  lastCommitTime = navic_millis();
   valid = updated = true;
 }
 
-void navic_time::setTime(const char *term)
+void NavIC_time::setTime(const NavIC_number &term)
 {
-  newTime = (uint32_t)navic_rmc_gga
-      Plus::parseDecimal(term);
+  newTime = (uint32_t)term.hundredths();
 }
 
-void navic_date::setDate(const char *term)
+void NavIC_date::setDate(const NavIC_number &term)
 {
-  newDate = atol(term);
+  newDate = term.unsignedValue();
 }
 
-uint16_t navic_date::year()
+uint16_t NavIC_date::year()
 {
   updated = false;
   uint16_t year = date % 100;
   return year + 2000;
 }
 
-uint8_t navic_date::month()
+uint8_t NavIC_date::month()
 {
   updated = false;
   return (date / 100) % 100;
 }
 
-uint8_t navic_date::day()
+uint8_t NavIC_date::day()
 {
   updated = false;
   return date / 10000;
 }
 
-uint8_t navic_time::hour()
+uint8_t NavIC_time::hour()
 {
   updated = false;
   return time / 1000000;
 }
 
-uint8_t navic_time::minute()
+uint8_t NavIC_time::minute()
 {
   updated = false;
   return (time / 10000) % 100;
 }
 
-uint8_t navic_time::second()
+uint8_t NavIC_time::second()
 {
   updated = false;
   return (time / 100) % 100;
 }
 
-uint8_t navic_time::centisecond()
+uint8_t NavIC_time::centisecond()
 {
   updated = false;
   return time % 100;
 }
 
-void navic_decimal::commit()
+void NavIC_decimal::commit()
 {
   val = newval;
-  lastCommitTime = millis();
+  lastCommitTime = navic_millis();
   valid = updated = true;
 }
 
-void navic_decimal::set(const char *term)
+void NavIC_decimal::set(const NavIC_number &term)
 {
-  newval = navic_rmc_gga
-      Plus::parseDecimal(term);
+  newval = term.hundredths();
 }
 
-void navic_integer::commit()
+void NavIC_integer::commit()
 {
   val = newval;
-  lastCommitTime = millis();
+  lastCommitTime = navic_millis();
   valid = updated = true;
 }
 
-void navic_integer::set(const char *term)
+void NavIC_integer::set(const NavIC_number &term)
 {
-  newval = atol(term);
+  newval = term.unsignedValue();
 }
 
-navic_custom::navic_custom(navic_gn_rmc_gga &navic, const char *_sentenceName, int _termNumber)
+NavIC_CUSTOM::NavIC_CUSTOM(navic_gn_rmc_gga &navic, const char *_sentenceName, int _termNumber)
 {
   begin(navic, _sentenceName, _termNumber);
 }
 
-void navic_custom::begin(navic_gn_rmc_gga &navic, const char *_sentenceName, int _termNumber)
+bool NavIC_CUSTOM::begin(navic_gn_rmc_gga &navic, const char *_sentenceName, int _termNumber)
 {
   lastCommitTime = 0;
   updated = valid = false;
   sentenceName = _sentenceName;
+  tag = navic_gn_rmc_gga::sentenceTag(_sentenceName);
   termNumber = _termNumber;
   memset(stagingBuffer, '\0', sizeof(stagingBuffer));
   memset(buffer, '\0', sizeof(buffer));
+  staged = buffer;
+  stagedLength = 0;
+
+  // a tag of 0 is no name that fits, and would never match
+  if (tag == 0)
+    return false;
 
   // Insert this item into the navic tree
   navic.insertCustom(this, _sentenceName, _termNumber);
+  return true;
 }
 
-void navic_custom::commit()
+void NavIC_CUSTOM::commit()
 {
-  strcpy(this->buffer, this->stagingBuffer);
-  lastCommitTime = millis();
+  if (staged != buffer)
+  {
+    memcpy(buffer, staged, stagedLength);
+    buffer[stagedLength] = '\0';
+    staged = buffer;
+  }
+  lastCommitTime = navic_millis();
   valid = updated = true;
 }
 
-void navic_custom::set(const char *term)
+// Copy a staged value that is not held by this listener
+void NavIC_CUSTOM::materialize()
 {
-  strncpy(this->stagingBuffer, term, sizeof(this->stagingBuffer));
+  if (staged != stagingBuffer && staged != buffer)
+  {
+    memcpy(stagingBuffer, staged, stagedLength);
+    staged = stagingBuffer;
+  }
 }
 
-void navic_gn_rmc_gga::insertCustom(navic_custom *pElt, const char *sentenceName, int termNumber)
+void navic_gn_rmc_gga::insertCustom(NavIC_CUSTOM *pElt, const char *sentenceName, int termNumber)
 {
-  navic_rmc_gga
-      Custom **ppelt;
+  NavIC_CUSTOM **ppelt;
 
   for (ppelt = &this->customElts; *ppelt != NULL; ppelt = &(*ppelt)->next)
   {
@@ -498,4 +1070,306 @@ void navic_gn_rmc_gga::insertCustom(navic_custom *pElt, const char *sentenceName
 
   pElt->next = *ppelt;
   *ppelt = pElt;
+  indexCustoms();
+}
+
+static unsigned customSlot(uint64_t tag)
+{
+  uint32_t h = ((uint32_t)tag ^ (uint32_t)(tag >> 32)) * 2654435761UL;
+  return (h >> 16) & (_NavIC_CUSTOM_SLOTS - 1);
+}
+
+// Rebuild the tag -> first listener index after the list has changed
+void navic_gn_rmc_gga::indexCustoms()
+{
+  memset(customIndex, 0, sizeof(customIndex));
+  customIndexFull = false;
+
+  for (NavIC_CUSTOM *p = customElts, *prev = NULL; p != NULL; prev = p, p = p->next)
+  {
+    if (p->tag == 0 || (prev != NULL && prev->tag == p->tag))
+      continue;
+    unsigned slot = customSlot(p->tag), i;
+    for (i = 0; i < _NavIC_CUSTOM_SLOTS && customIndex[slot] != NULL; ++i)
+      slot = (slot + 1) & (_NavIC_CUSTOM_SLOTS - 1);
+    if (i == _NavIC_CUSTOM_SLOTS)
+      customIndexFull = true;
+    else
+      customIndex[slot] = p;
+  }
+}
+
+NavIC_CUSTOM *navic_gn_rmc_gga::findCustoms(uint64_t tag) const
+{
+  if (tag == 0)
+    return NULL;
+
+  // More sentence types than slots: fall back to walking the list
+  if (customIndexFull)
+  {
+    for (NavIC_CUSTOM *p = customElts; p != NULL; p = p->next)
+      if (p->tag == tag)
+        return p;
+    return NULL;
+  }
+
+  unsigned slot = customSlot(tag);
+  for (unsigned i = 0; i < _NavIC_CUSTOM_SLOTS && customIndex[slot] != NULL; ++i)
+  {
+    if (customIndex[slot]->tag == tag)
+      return customIndex[slot];
+    slot = (slot + 1) & (_NavIC_CUSTOM_SLOTS - 1);
+  }
+  return NULL;
+}
+
+void NavIC_satellites_in_view::setTerm(uint8_t talker, uint8_t termNumber, const NavIC_number &term)
+{
+  switch (termNumber)
+  {
+  case 1: // Total number of messages
+    seqTotal = term.unsignedValue();
+    break;
+  case 2: // Message number; a sequence must arrive in order from one talker
+  {
+    uint8_t msg = term.unsignedValue();
+    if (msg == 1)
+    {
+      abandon();
+      staged = 0;
+      seqTalker = talker;
+      seqNext = 1;
+      seqBase = n;
+    }
+    if (msg != seqNext || talker != seqTalker)
+    {
+      abandon();
+      seqNext = 0;
+    }
+    sentenceStaged = 0;
+    break;
+  }
+  case 3: // Satellites in view, known before the first part stages any
+    if (seqNext == 1)
+      makeRoom(term.unsignedValue());
+    break;
+  default: // PRN, elevation, azimuth, SNR for up to four satellites
+  {
+    uint8_t slot = seqBase + staged + (termNumber - 4) / 4;
+    if (seqNext == 0 || slot >= _NavIC_MAX_SATELLITES)
+      break;
+    switch ((termNumber - 4) % 4)
+    {
+    case 0:
+      prns[slot] = term.unsignedValue();
+      elevations[slot] = 0;
+      azimuths[slot] = 0;
+      snrs[slot] = 0;
+      talkers[slot] = talker;
+      sentenceStaged = slot - seqBase - staged + 1;
+      break;
+    case 1:
+      elevations[slot] = term.signedValue();
+      break;
+    case 2:
+      azimuths[slot] = term.unsignedValue();
+      break;
+    case 3:
+      snrs[slot] = term.unsignedValue();
+      break;
+    }
+    break;
+  }
+  }
+}
+
+// Too little free tail for the sequence: move the talker's old entries to
+// the end, keeping the others in order, and stage over them
+void NavIC_satellites_in_view::makeRoom(uint8_t needed)
+{
+  if (n + needed <= _NavIC_MAX_SATELLITES)
+    return;
+  uint8_t kept = 0;
+  for (uint8_t i = 0; i < n; ++i)
+  {
+    if (talkers[i] == seqTalker)
+      continue;
+    if (i != kept)
+    {
+      uint8_t prn = prns[kept], talker = talkers[kept], snr = snrs[kept];
+      int8_t elevation = elevations[kept];
+      uint16_t azimuth = azimuths[kept];
+      prns[kept] = prns[i];
+      elevations[kept] = elevations[i];
+      azimuths[kept] = azimuths[i];
+      snrs[kept] = snrs[i];
+      talkers[kept] = talkers[i];
+      prns[i] = prn;
+      elevations[i] = elevation;
+      azimuths[i] = azimuth;
+      snrs[i] = snr;
+      talkers[i] = talker;
+    }
+    ++kept;
+  }
+  seqBase = kept;
+}
+
+// A sequence broke off; entries it overwrote in place are no longer whole
+void NavIC_satellites_in_view::abandon()
+{
+  if (seqNext != 0 && seqBase < n && (staged != 0 || sentenceStaged != 0))
+    n = seqBase;
+}
+
+// Called once a GSV part has passed its checksum; termCount excludes the
+// checksum.  A trailing NMEA 4.10 signal ID looks like the PRN of a fifth
+// group, so only whole groups of four terms count.
+void NavIC_satellites_in_view::commit(uint8_t termCount)
+{
+  if (seqNext == 0)
+    return;
+  uint8_t groups = termCount > 4 ? (termCount - 4) / 4 : 0;
+  staged += groups < sentenceStaged ? groups : sentenceStaged;
+  sentenceStaged = 0;
+  if (seqNext++ < seqTotal)
+    return;
+
+  if (seqBase < n)
+  {
+    // Staged over the talker's old entries, which were last
+    n = seqBase + staged;
+  }
+  else
+  {
+    // Last part: drop this talker's old entries, then close the gap
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < n + staged; ++i)
+    {
+      if (i < n && talkers[i] == seqTalker)
+        continue;
+      prns[kept] = prns[i];
+      elevations[kept] = elevations[i];
+      azimuths[kept] = azimuths[i];
+      snrs[kept] = snrs[i];
+      talkers[kept] = talkers[i];
+      ++kept;
+    }
+    n = kept;
+  }
+  staged = 0;
+  seqNext = 0;
+  lastCommitTime = navic_millis();
+  valid = updated = true;
+}
+
+void NavIC_active_satellites::setTerm(uint8_t talker, uint8_t termNumber, const NavIC_number &term, const char *head)
+{
+  switch (termNumber)
+  {
+  case 1: // Selection mode
+    newN = 0;
+    newTalker = talker;
+    newSystem = 0;
+    newPdop = newHdop = newVdop = 0;
+    break;
+  case 2: // Fix type
+    newType = term.unsignedValue();
+    break;
+  case 15:
+    newPdop = term.hundredths();
+    break;
+  case 16:
+    newHdop = term.hundredths();
+    break;
+  case 17:
+    newVdop = term.hundredths();
+    break;
+  case 18: // a hex digit
+    newSystem = strtol(head, NULL, 16);
+    break;
+  default: // PRNs of the satellites used, empty slots skipped
+    if (termNumber >= 3 && termNumber < 3 + _NavIC_MAX_ACTIVE_SATELLITES && head[0])
+      newPrns[newN++] = term.unsignedValue();
+    break;
+  }
+}
+
+// Replaces the entries of this GSA's talker and system with its PRNs
+void NavIC_active_satellites::commit()
+{
+  uint8_t kept = 0;
+  for (uint8_t i = 0; i < n; ++i)
+  {
+    if (talkers[i] == newTalker && systems[i] == newSystem)
+      continue;
+    prns[kept] = prns[i];
+    talkers[kept] = talkers[i];
+    systems[kept] = systems[i];
+    ++kept;
+  }
+  for (uint8_t i = 0; i < newN && kept < _NavIC_MAX_SATELLITES; ++i, ++kept)
+  {
+    prns[kept] = newPrns[i];
+    talkers[kept] = newTalker;
+    systems[kept] = newSystem;
+  }
+  n = kept;
+  type = newType;
+  system = newSystem;
+  pdopVal = newPdop;
+  hdopVal = newHdop;
+  vdopVal = newVdop;
+  lastCommitTime = navic_millis();
+  valid = updated = true;
+}
+
+NavIC_LISTENER::NavIC_LISTENER(navic_gn_rmc_gga &navic, NavIC_fix_callback callback, void *context, uint16_t sentences)
+    : navic(0), next(0)
+{
+  begin(navic, callback, context, sentences);
+}
+
+void NavIC_LISTENER::begin(navic_gn_rmc_gga &_navic, NavIC_fix_callback _callback, void *_context, uint16_t sentences)
+{
+  end();
+  callback = _callback;
+  context = _context;
+  sentenceMask = sentences ? sentences : _NavIC_FIX_SENTENCES;
+  navic = &_navic;
+
+  next = navic->listeners;
+  navic->listeners = this;
+}
+
+void NavIC_LISTENER::end()
+{
+  if (navic == NULL)
+    return;
+  for (NavIC_LISTENER **pp = &navic->listeners; *pp != NULL; pp = &(*pp)->next)
+    if (*pp == this)
+    {
+      *pp = next;
+      break;
+    }
+  navic = NULL;
+  next = NULL;
+}
+
+void navic_gn_rmc_gga::notifyListeners()
+{
+  uint16_t bit = _NavIC_SENTENCE_MASK(curSentenceType);
+  NavIC_fix fix;
+  bool taken = false;
+  for (NavIC_LISTENER *p = listeners, *next; p != NULL; p = next)
+  {
+    next = p->next; // the callback may end() p
+    if (p->sentenceMask & bit)
+    {
+      if (!taken)
+        snapshot(fix);
+      taken = true;
+      p->callback(fix, p->context);
+    }
+  }
 }
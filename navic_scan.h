@@ -0,0 +1,84 @@
+/*
+navic_scan - delimiter search helpers for the bulk NMEA decode path
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+#ifndef __navic_scan_h
+#define __navic_scan_h
+
+#include "navic_platform.h"
+#include <string.h>
+
+#define _NavIC_SWAR_ONES 0x0101010101010101ULL
+#define _NavIC_SWAR_HIGHS 0x8080808080808080ULL
+
+// High bit set in every byte of x equal to c (exact for the lowest match)
+static inline uint64_t navic_swar_eq(uint64_t x, uint8_t c)
+{
+  uint64_t v = x ^ (_NavIC_SWAR_ONES * c);
+  return (v - _NavIC_SWAR_ONES) & ~v & _NavIC_SWAR_HIGHS;
+}
+
+static inline uint8_t navic_fold_parity(uint64_t x)
+{
+  x ^= x >> 32;
+  x ^= x >> 16;
+  x ^= x >> 8;
+  return (uint8_t)x;
+}
+
+static inline bool navic_is_delimiter(char c, bool comma)
+{
+  return c == '$' || c == '*' || c == '\r' || c == '\n' || (comma && c == ',');
+}
+
+// Returns the offset of the first NMEA delimiter ('$', '*', '\r', '\n' and,
+// if Comma, ',') in p[0..n), or n if there is none.  If Parity, every byte
+// before the delimiter is XORed into parity.
+template <bool Comma, bool Parity>
+static inline size_t navic_scan(const char *p, size_t n, uint8_t &parity)
+{
+  size_t i = 0;
+#ifdef _NavIC_SWAR
+  uint64_t acc = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    uint64_t x;
+    memcpy(&x, p + i, 8);
+    uint64_t hit = navic_swar_eq(x, '$') | navic_swar_eq(x, '*') |
+                   navic_swar_eq(x, '\r') | navic_swar_eq(x, '\n');
+    if (Comma)
+      hit |= navic_swar_eq(x, ',');
+    if (hit)
+    {
+      unsigned bytes = __builtin_ctzll(hit) >> 3;
+      if (Parity && bytes)
+        acc ^= x & (~0ULL >> (64 - 8 * bytes));
+      if (Parity)
+        parity ^= navic_fold_parity(acc);
+      return i + bytes;
+    }
+    if (Parity)
+      acc ^= x;
+  }
+  if (Parity)
+    parity ^= navic_fold_parity(acc);
+#endif
+  for (; i < n; ++i)
+  {
+    if (navic_is_delimiter(p[i], Comma))
+      break;
+    if (Parity)
+      parity ^= (uint8_t)p[i];
+  }
+  return i;
+}
+
+#endif // def(__navic_scan_h)
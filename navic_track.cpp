@@ -0,0 +1,382 @@
+/*
+navic_track - constant-velocity Kalman filter over committed fixes, with
+HDOP-weighted position noise and outlier rejection
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_track.h"
+
+#if !_NavIC_TRACK_FIXED
+#include <math.h>
+#endif
+
+#define _NavIC_METERS_PER_E7 0.011122629 // as distanceBetween(): 6372795 m * pi / 180 / 10^7
+#define _NavIC_CENTISECONDS_PER_DAY 8640000UL
+#define _NavIC_TRACK_START_SPEED 10.0 // m/s (1 sigma) of a filter started without RMC velocity
+
+typedef navic_track_real real;
+
+// The arithmetic below is written once for both float and NavIC_fixed;
+// only these helpers differ
+
+static real fromRatio(int32_t num, int32_t den)
+{
+#if _NavIC_TRACK_FIXED
+  return NavIC_fixed::ratio(num, den);
+#else
+  return (float)num / den;
+#endif
+}
+
+static int32_t toInt(real x)
+{
+#if _NavIC_TRACK_FIXED
+  return x.round();
+#else
+  return (int32_t)(x < 0 ? x - 0.5f : x + 0.5f);
+#endif
+}
+
+static real squareRoot(real x)
+{
+#if _NavIC_TRACK_FIXED
+  if (x.raw <= 0)
+    return real();
+  // bit by bit integer square root of raw * 2^16, which is raw's in 16.16
+  uint64_t v = (uint64_t)x.raw << 16, root = 0;
+  for (uint64_t bit = 1ULL << 46; bit != 0; bit >>= 2)
+    if (v >= root + bit)
+    {
+      v -= root + bit;
+      root = (root >> 1) + bit;
+    }
+    else
+      root >>= 1;
+  return NavIC_fixed::fromRaw((int32_t)root);
+#else
+  return x > 0 ? sqrtf(x) : 0;
+#endif
+}
+
+static real magnitude(real x)
+{
+  return x < real(0.0) ? -x : x;
+}
+
+// Sine and cosine of an angle in hundredths of a degree, by Taylor
+// series over the first quadrant; good to about 10^-6
+static void sinCos(int32_t centiDegrees, real &s, real &c)
+{
+  int32_t a = centiDegrees % 36000;
+  if (a < 0)
+    a += 36000;
+  uint8_t quadrant = a / 9000;
+  real x = fromRatio(a - quadrant * 9000, 9000) * real(PI / 2);
+  real x2 = x * x;
+  real sx = x * (real(1.0) - x2 * real(1 / 6.0) * (real(1.0) - x2 * real(1 / 20.0) * (real(1.0) - x2 * real(1 / 42.0) * (real(1.0) - x2 * real(1 / 72.0)))));
+  real cx = real(1.0) - x2 * real(1 / 2.0) * (real(1.0) - x2 * real(1 / 12.0) * (real(1.0) - x2 * real(1 / 30.0) * (real(1.0) - x2 * real(1 / 56.0) * (real(1.0) - x2 * real(1 / 90.0)))));
+  switch (quadrant)
+  {
+  case 0:
+    s = sx;
+    c = cx;
+    break;
+  case 1:
+    s = cx;
+    c = -sx;
+    break;
+  case 2:
+    s = -sx;
+    c = -cx;
+    break;
+  default:
+    s = -cx;
+    c = sx;
+    break;
+  }
+}
+
+// Direction of (east, north) in hundredths of a degree clockwise from
+// north; the arctangent polynomial is good to about 10^-5 radians
+static uint16_t bearing(real east, real north)
+{
+  real ae = magnitude(east), an = magnitude(north);
+  if (!(ae > real(0.0)) && !(an > real(0.0)))
+    return 0;
+  bool steep = ae > an;
+  real z = steep ? an / ae : ae / an;
+  real z2 = z * z;
+  real a = z * (real(0.9998660) + z2 * (real(-0.3302995) + z2 * (real(0.1801410) + z2 * (real(-0.0851330) + z2 * real(0.0208351)))));
+  int32_t d = toInt(a * real(18000 / PI));
+  d = steep ? 9000 - d : d;
+  d = north < real(0.0) ? 18000 - d : d;
+  d = east < real(0.0) ? 36000 - d : d;
+  return d >= 36000 ? d - 36000 : d;
+}
+
+// hhmmsscc to centiseconds of the day
+static uint32_t centiseconds(uint32_t time)
+{
+  return time / 1000000 * 360000 + time / 10000 % 100 * 6000 + time % 10000;
+}
+
+navic_track_filter::navic_track_filter()
+    : valid(false), updated(false), rejectsInRow(0), lastTime(0), originLat(0), originLng(0),
+      east(), north(), eastVelocity(), northVelocity(), p00(), p01(), p11(),
+      residualCm(), distanceCm(0), acceptedCount(0), rejectedCount(0)
+{
+  setOrigin(0, 0);
+}
+
+void navic_track_filter::begin(navic_gn_rmc_gga &navic)
+{
+  listener.begin(navic, onFix, this);
+}
+
+void navic_track_filter::end()
+{
+  listener.end();
+}
+
+void navic_track_filter::reset()
+{
+  valid = false;
+}
+
+void navic_track_filter::onFix(const NavIC_fix &fix, void *context)
+{
+  static_cast<navic_track_filter *>(context)->update(fix);
+}
+
+bool navic_track_filter::update(const NavIC_fix &fix)
+{
+  if (!(fix.committed & NavIC_fix::LOCATION))
+    return false;
+
+  // a missing or zero HDOP counts as 1
+  int32_t hdop = (fix.fields & NavIC_fix::HDOP) && fix.hdop > 0 ? fix.hdop : 100;
+  if (hdop > _NavIC_TRACK_MAX_HDOP)
+  {
+    ++rejectedCount;
+    return false;
+  }
+  real sigma = fromRatio(hdop, 100) * real(_NavIC_TRACK_UERE);
+  real r = sigma * sigma;
+
+  uint32_t time = fix.fields & NavIC_fix::TIME ? centiseconds(fix.time) : navic_millis() / 10 % _NavIC_CENTISECONDS_PER_DAY;
+  uint32_t dt = (time + _NavIC_CENTISECONDS_PER_DAY - lastTime) % _NavIC_CENTISECONDS_PER_DAY;
+  if (!valid || dt > _NavIC_TRACK_MAX_GAP)
+  {
+    start(fix, r, time);
+    return true;
+  }
+
+  // The second sentence of an epoch (GGA after RMC, say) repeats its
+  // position, which must not count twice; only its velocity is news
+  if (dt == 0)
+  {
+    correctVelocity(fix);
+    return true;
+  }
+
+  real lastEast = east, lastNorth = north;
+  predict(fromRatio(dt, 100));
+  lastTime = time;
+
+  real measuredEast, measuredNorth;
+  measure(fix, measuredEast, measuredNorth);
+  if (!correctPosition(measuredEast, measuredNorth, r))
+  {
+    ++rejectedCount;
+    // a run of outliers is more likely a filter that has lost the track
+    if (++rejectsInRow >= _NavIC_TRACK_MAX_REJECTS)
+      valid = false;
+    return false;
+  }
+  rejectsInRow = 0;
+  correctVelocity(fix);
+
+  real dEast = east - lastEast, dNorth = north - lastNorth;
+  residualCm += squareRoot(dEast * dEast + dNorth * dNorth) * real(100.0);
+  int32_t whole = toInt(residualCm);
+  if (whole > 0)
+  {
+    distanceCm += whole;
+    residualCm -= fromRatio(whole, 1);
+  }
+
+  // keep the local plane small enough for float and 16.16 precision
+  if (magnitude(east) > real(_NavIC_TRACK_RECENTER) || magnitude(north) > real(_NavIC_TRACK_RECENTER))
+  {
+    setOrigin(toLatE7(north), toLngE7(east));
+    east = north = real();
+  }
+
+  ++acceptedCount;
+  updated = true;
+  return true;
+}
+
+void navic_track_filter::start(const NavIC_fix &fix, real r, uint32_t time)
+{
+  setOrigin(fix.lat.e7(), fix.lng.e7());
+  east = north = eastVelocity = northVelocity = real();
+  p00 = r;
+  p01 = real();
+  p11 = real(_NavIC_TRACK_START_SPEED * _NavIC_TRACK_START_SPEED);
+  correctVelocity(fix);
+  lastTime = time;
+  rejectsInRow = 0;
+  valid = updated = true;
+  ++acceptedCount;
+}
+
+void navic_track_filter::setOrigin(int32_t latE7, int32_t lngE7)
+{
+  originLat = latE7;
+  originLng = lngE7;
+  real s, c;
+  sinCos(latE7 / 100000, s, c);
+  // the plane is degenerate within a few kilometers of a pole
+  if (c < real(0.01))
+    c = real(0.01);
+#if _NavIC_TRACK_FIXED
+  // meters in 16.16 = dE7 * scale >> 16, and dE7 = meters.raw * inverse >> 32
+  northScale = (int64_t)(_NavIC_METERS_PER_E7 * 4294967296.0);
+  eastScale = northScale * c.raw >> 16;
+  northInverse = (int64_t)(65536.0 / _NavIC_METERS_PER_E7);
+  eastInverse = (northInverse << 16) / c.raw;
+#else
+  northScale = (float)_NavIC_METERS_PER_E7;
+  eastScale = northScale * c;
+#endif
+}
+
+void navic_track_filter::measure(const NavIC_fix &fix, real &east, real &north) const
+{
+  int64_t dLat = (int64_t)fix.lat.e7() - originLat;
+  int64_t dLng = (int64_t)fix.lng.e7() - originLng;
+  // the short way across the antimeridian
+  if (dLng > 1800000000LL)
+    dLng -= 3600000000LL;
+  else if (dLng < -1800000000LL)
+    dLng += 3600000000LL;
+#if _NavIC_TRACK_FIXED
+  north = NavIC_fixed::saturate(dLat * northScale >> 16);
+  east = NavIC_fixed::saturate(dLng * eastScale >> 16);
+#else
+  north = (float)dLat * northScale;
+  east = (float)dLng * eastScale;
+#endif
+}
+
+int32_t navic_track_filter::toLatE7(real north) const
+{
+#if _NavIC_TRACK_FIXED
+  return originLat + (int32_t)(north.raw * northInverse >> 32);
+#else
+  return originLat + toInt(north / northScale);
+#endif
+}
+
+int32_t navic_track_filter::toLngE7(real east) const
+{
+#if _NavIC_TRACK_FIXED
+  int64_t lng = originLng + (east.raw * eastInverse >> 32);
+#else
+  int64_t lng = originLng + (int64_t)toInt(east / eastScale);
+#endif
+  return (int32_t)(lng > 1800000000LL ? lng - 3600000000LL : lng < -1800000000LL ? lng + 3600000000LL : lng);
+}
+
+// Moves the state dt seconds on at constant velocity, with white noise
+// acceleration of _NavIC_TRACK_ACCELERATION
+void navic_track_filter::predict(real dt)
+{
+  const real q = real(_NavIC_TRACK_ACCELERATION * _NavIC_TRACK_ACCELERATION);
+  real dt2 = dt * dt;
+  east += eastVelocity * dt;
+  north += northVelocity * dt;
+  p00 += dt * (p01 + p01 + dt * p11) + q * dt2 * dt * real(1 / 3.0);
+  p01 += dt * p11 + q * dt2 * real(1 / 2.0);
+  p11 += q * dt;
+}
+
+// Position update with noise r on each axis.  Returns false, leaving the
+// state as it was, if the innovation falls outside the gate.
+bool navic_track_filter::correctPosition(real measuredEast, real measuredNorth, real r)
+{
+  real s = p00 + r;
+  real yEast = measuredEast - east, yNorth = measuredNorth - north;
+  // divided before squaring, so that in 16.16 an innovation too large to
+  // square saturates upward, out of the gate, whatever s is
+  if ((yEast / s) * yEast + (yNorth / s) * yNorth > real(_NavIC_TRACK_GATE))
+    return false;
+
+  real k0 = p00 / s, k1 = p01 / s;
+  east += k0 * yEast;
+  north += k0 * yNorth;
+  eastVelocity += k1 * yEast;
+  northVelocity += k1 * yNorth;
+  p11 -= k1 * p01;
+  p01 -= k0 * p01;
+  p00 -= k0 * p00;
+  return true;
+}
+
+// Velocity update from RMC speed and course, when the commit has both
+void navic_track_filter::correctVelocity(const NavIC_fix &fix)
+{
+  if ((fix.committed & (NavIC_fix::SPEED | NavIC_fix::COURSE)) != (NavIC_fix::SPEED | NavIC_fix::COURSE))
+    return;
+
+  real speed = fromRatio(fix.speed, 100) * real(_NavIC_MPS_PER_KNOT);
+  real s, c;
+  sinCos(fix.course, s, c);
+  real yEast = speed * s - eastVelocity, yNorth = speed * c - northVelocity;
+
+  real sum = p11 + real(_NavIC_TRACK_SPEED_SIGMA * _NavIC_TRACK_SPEED_SIGMA);
+  real k0 = p01 / sum, k1 = p11 / sum;
+  east += k0 * yEast;
+  north += k0 * yNorth;
+  eastVelocity += k1 * yEast;
+  northVelocity += k1 * yNorth;
+  p00 -= k0 * p01;
+  p01 -= k0 * p11;
+  p11 -= k1 * p11;
+}
+
+int32_t navic_track_filter::latE7()
+{
+  updated = false;
+  return toLatE7(north);
+}
+
+int32_t navic_track_filter::lngE7()
+{
+  updated = false;
+  return toLngE7(east);
+}
+
+int32_t navic_track_filter::cmps() const
+{
+  return toInt(squareRoot(eastVelocity * eastVelocity + northVelocity * northVelocity) * real(100.0));
+}
+
+uint16_t navic_track_filter::centiDegrees() const
+{
+  return bearing(eastVelocity, northVelocity);
+}
+
+uint32_t navic_track_filter::accuracyCm() const
+{
+  return toInt(squareRoot(p00) * real(100.0));
+}
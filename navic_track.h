@@ -0,0 +1,146 @@
+/*
+navic_track - constant-velocity Kalman filter over committed fixes, with
+HDOP-weighted position noise and outlier rejection
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+#ifndef __navic_track_h
+#define __navic_track_h
+
+#include "navic_rmc_gga++.h"
+
+// 1 runs the filter in 16.16 fixed point, for MCUs without an FPU; 0 in
+// single-precision float
+#ifndef _NavIC_TRACK_FIXED
+#define _NavIC_TRACK_FIXED 0
+#endif
+#ifndef _NavIC_TRACK_UERE
+#define _NavIC_TRACK_UERE 4.0 // meters of position error (1 sigma) per unit of HDOP
+#endif
+#ifndef _NavIC_TRACK_ACCELERATION
+#define _NavIC_TRACK_ACCELERATION 1.0 // m/s^2 of unmodelled acceleration (1 sigma)
+#endif
+#ifndef _NavIC_TRACK_SPEED_SIGMA
+#define _NavIC_TRACK_SPEED_SIGMA 0.5 // m/s of RMC speed/course error (1 sigma)
+#endif
+#ifndef _NavIC_TRACK_GATE
+#define _NavIC_TRACK_GATE 16.0 // squared normalised innovation beyond which a fix is an outlier
+#endif
+#ifndef _NavIC_TRACK_MAX_REJECTS
+#define _NavIC_TRACK_MAX_REJECTS 5 // outliers in a row after which the filter restarts on the next fix
+#endif
+#define _NavIC_TRACK_MAX_HDOP 2000 // hundredths; fixes any worse are ignored
+#define _NavIC_TRACK_MAX_GAP 1000  // centiseconds without a fix after which the filter restarts
+#define _NavIC_TRACK_RECENTER 2000 // meters from the origin at which the local plane moves
+
+#if _NavIC_TRACK_FIXED
+// Signed 16.16 fixed point; sums, products and quotients saturate rather
+// than wrap
+struct NavIC_fixed
+{
+   int32_t raw;
+
+   NavIC_fixed() : raw(0) {}
+   // for constants: folded at compile time
+   constexpr NavIC_fixed(double v) : raw((int32_t)(v * 65536.0 + (v < 0 ? -0.5 : 0.5))) {}
+   static NavIC_fixed fromRaw(int32_t raw)
+   {
+      NavIC_fixed f;
+      f.raw = raw;
+      return f;
+   }
+   static NavIC_fixed ratio(int32_t num, int32_t den) { return saturate(((int64_t)num << 16) / den); }
+   static NavIC_fixed saturate(int64_t v) { return fromRaw(v > 0x7FFFFFFFLL ? 0x7FFFFFFF : v < -0x7FFFFFFFLL ? -0x7FFFFFFF : (int32_t)v); }
+   int32_t round() const { return (raw + (raw < 0 ? -32768 : 32768)) / 65536; }
+
+   NavIC_fixed operator+(NavIC_fixed b) const { return saturate((int64_t)raw + b.raw); }
+   NavIC_fixed operator-(NavIC_fixed b) const { return saturate((int64_t)raw - b.raw); }
+   NavIC_fixed operator-() const { return fromRaw(-raw); }
+   NavIC_fixed operator*(NavIC_fixed b) const { return saturate(((int64_t)raw * b.raw) >> 16); }
+   NavIC_fixed operator/(NavIC_fixed b) const { return b.raw ? saturate(((int64_t)raw << 16) / b.raw) : fromRaw(raw < 0 ? -0x7FFFFFFF : 0x7FFFFFFF); }
+   NavIC_fixed &operator+=(NavIC_fixed b) { return *this = *this + b; }
+   NavIC_fixed &operator-=(NavIC_fixed b) { return *this = *this - b; }
+   bool operator<(NavIC_fixed b) const { return raw < b.raw; }
+   bool operator>(NavIC_fixed b) const { return raw > b.raw; }
+};
+typedef NavIC_fixed navic_track_real;
+#else
+typedef float navic_track_real;
+#endif
+
+// Smooths the RMC/GGA fixes of a parser, or any NavIC_fix passed to
+// update(), in a local east/north plane around a recent fix.  One
+// covariance serves both axes, as the position noise is the same on
+// each; an update costs a few dozen multiplies and a few divisions.
+// Nothing is allocated.
+class navic_track_filter
+{
+public:
+   navic_track_filter();
+   ~navic_track_filter() { end(); }
+   void begin(navic_gn_rmc_gga &navic); // filter every fix navic commits
+   void end();
+   void reset(); // restart on the next fix
+
+   // Feeds one commit; returns false if it carried no usable location or
+   // was rejected as an outlier
+   bool update(const NavIC_fix &fix);
+
+   bool isValid() const { return valid; }
+   bool isUpdated() const { return updated; }
+   int32_t latE7(); // degrees * 10^7
+   int32_t lngE7();
+   double lat() { return latE7() / 1e7; }
+   double lng() { return lngE7() / 1e7; }
+   int32_t cmps() const;                               // speed, cm/s
+   uint16_t centiDegrees() const;                      // course, hundredths of a degree true
+   uint32_t accuracyCm() const;                        // position error (1 sigma)
+   uint32_t centimeters() const { return distanceCm; } // length of the filtered track
+
+   uint32_t accepted() const { return acceptedCount; }
+   uint32_t rejected() const { return rejectedCount; }
+
+private:
+   navic_track_filter(const navic_track_filter &);
+   navic_track_filter &operator=(const navic_track_filter &);
+
+   static void onFix(const NavIC_fix &fix, void *context);
+   void start(const NavIC_fix &fix, navic_track_real r, uint32_t time);
+   void setOrigin(int32_t latE7, int32_t lngE7);
+   void predict(navic_track_real dt);
+   bool correctPosition(navic_track_real east, navic_track_real north, navic_track_real r);
+   void correctVelocity(const NavIC_fix &fix);
+   void measure(const NavIC_fix &fix, navic_track_real &east, navic_track_real &north) const;
+   int32_t toLatE7(navic_track_real north) const;
+   int32_t toLngE7(navic_track_real east) const;
+
+   NavIC_LISTENER listener;
+   bool valid, updated;
+   uint8_t rejectsInRow;
+   uint32_t lastTime; // centiseconds of the day of the last fix
+
+   // local plane: origin and meters per 10^-7 degree, both ways
+   int32_t originLat, originLng;
+#if _NavIC_TRACK_FIXED
+   int64_t northScale, eastScale, northInverse, eastInverse;
+#else
+   float northScale, eastScale;
+#endif
+
+   // state per axis, meters and m/s, and the shared covariance
+   navic_track_real east, north, eastVelocity, northVelocity;
+   navic_track_real p00, p01, p11;
+
+   navic_track_real residualCm;
+   uint32_t distanceCm;
+   uint32_t acceptedCount, rejectedCount;
+};
+
+#endif // def(__navic_track_h)
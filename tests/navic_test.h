@@ -0,0 +1,49 @@
+/*
+navic_test - what the regression tests in tests/ share
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+#ifndef __navic_test_h
+#define __navic_test_h
+
+#include <stdio.h>
+#include <string>
+
+static int navic_test_failures = 0;
+
+#define CHECK(cond)                                                    \
+   do                                                                  \
+   {                                                                   \
+      if (!(cond))                                                     \
+      {                                                                \
+         fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+         ++navic_test_failures;                                        \
+      }                                                                \
+   } while (0)
+
+// The body between '$' and '*' framed as a sentence with its checksum
+inline std::string nmea(const std::string &body)
+{
+   unsigned char sum = 0;
+   for (size_t i = 0; i < body.size(); ++i)
+      sum ^= (unsigned char)body[i];
+   char tail[8];
+   snprintf(tail, sizeof(tail), "*%02X\r\n", sum);
+   return "$" + body + tail;
+}
+
+inline int navic_test_result()
+{
+   if (navic_test_failures != 0)
+      fprintf(stderr, "%d checks failed\n", navic_test_failures);
+   return navic_test_failures != 0;
+}
+
+#endif // def(__navic_test_h)
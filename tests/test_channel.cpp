@@ -0,0 +1,125 @@
+/*
+test_channel - navic_fix_channel hands readers whole fixes only
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_channel.h"
+#include "navic_test.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+const uint32_t PUBLISHES = 200000;
+const int READERS = 3;
+
+// Every member follows from k, so a fix mixed from two publishes shows
+NavIC_fix numbered(uint32_t k)
+{
+  NavIC_fix fix;
+  fix.lat.deg = k % 90;
+  fix.lat.billionths = k;
+  fix.lat.negative = k & 1;
+  fix.lng.deg = k % 180;
+  fix.lng.billionths = ~k;
+  fix.lng.negative = k & 2;
+  fix.date = k * 3;
+  fix.time = k;
+  fix.speed = -(int32_t)k;
+  fix.course = k ^ 0x5A5A5A5A;
+  fix.altitude = k * 7;
+  fix.satellites = k + 1;
+  fix.hdop = k * 11;
+  fix.sentence = k & 0xFF;
+  fix.talker = (k >> 8) & 0xFF;
+  fix.fields = (k >> 16) & 0xFF;
+  fix.committed = (k >> 24) & 0xFF;
+  return fix;
+}
+
+bool whole(const NavIC_fix &fix)
+{
+  const NavIC_fix expected = numbered(fix.time);
+  return fix.lat.deg == expected.lat.deg && fix.lat.billionths == expected.lat.billionths &&
+         fix.lat.negative == expected.lat.negative && fix.lng.deg == expected.lng.deg &&
+         fix.lng.billionths == expected.lng.billionths && fix.lng.negative == expected.lng.negative &&
+         fix.date == expected.date && fix.speed == expected.speed && fix.course == expected.course &&
+         fix.altitude == expected.altitude && fix.satellites == expected.satellites && fix.hdop == expected.hdop &&
+         fix.sentence == expected.sentence && fix.talker == expected.talker && fix.fields == expected.fields &&
+         fix.committed == expected.committed;
+}
+}
+
+int main()
+{
+  // Nothing to read until the first publish, then exactly what went in
+  navic_fix_channel channel;
+  NavIC_fix fix;
+  CHECK(!channel.read(fix));
+  CHECK(channel.published() == 0);
+  channel.publish(numbered(42));
+  CHECK(channel.read(fix) && fix.time == 42 && whole(fix));
+  CHECK(channel.published() == 1);
+
+  // Attached to a parser, each RMC commit is published
+  navic_gn_rmc_gga navic;
+  navic_fix_channel attached;
+  attached.attach(navic);
+  std::string rmc = nmea("GPRMC,123519.00,A,4807.038,N,01131.000,E,022.4,084.4,230394,,,A");
+  navic.encode(rmc.data(), rmc.size());
+  CHECK(attached.published() == 1);
+  CHECK(attached.read(fix) && fix.time == 12351900 && fix.date == 230394 && fix.lat.deg == 48);
+  attached.detach();
+  navic.encode(rmc.data(), rmc.size());
+  CHECK(attached.published() == 1);
+
+  // One writer, several readers: no read is torn, and each reader sees
+  // the publishes in order
+  navic_fix_channel shared;
+  std::atomic<bool> done(false);
+  std::atomic<uint32_t> torn(0), backwards(0), reads(0);
+  std::vector<std::thread> readers;
+  for (int r = 0; r < READERS; ++r)
+    readers.push_back(std::thread([&]() {
+      uint32_t last = 0, count = 0;
+      NavIC_fix seen;
+      while (!done.load(std::memory_order_acquire))
+      {
+        if (!shared.read(seen))
+          continue;
+        ++count;
+        if (!whole(seen))
+          ++torn;
+        if (seen.time < last)
+          ++backwards;
+        last = seen.time;
+      }
+      reads += count;
+    }));
+  for (uint32_t k = 1; k <= PUBLISHES; ++k)
+  {
+    shared.publish(numbered(k));
+    if (k % 1000 == 0)
+      std::this_thread::yield();
+  }
+  done.store(true, std::memory_order_release);
+  for (size_t r = 0; r < readers.size(); ++r)
+    readers[r].join();
+  CHECK(torn == 0);
+  CHECK(backwards == 0);
+  CHECK(reads > 0);
+  CHECK(shared.published() == PUBLISHES);
+  CHECK(shared.read(fix) && fix.time == PUBLISHES && whole(fix));
+
+  return navic_test_result();
+}
@@ -0,0 +1,42 @@
+/*
+test_custom - NavIC_CUSTOM on names that do and do not fit a tag
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_rmc_gga++.h"
+#include "navic_test.h"
+
+#include <string.h>
+
+int main()
+{
+  navic_gn_rmc_gga navic;
+  NavIC_CUSTOM standard, eight, nine, empty;
+  CHECK(standard.begin(navic, "GNRMC", 2));
+  CHECK(eight.begin(navic, "PABCDEFG", 1));
+  // too long to pack: refused rather than silently never matching
+  CHECK(!nine.begin(navic, "PABCDEFGH", 1));
+  CHECK(!empty.begin(navic, "", 1));
+  CHECK(standard.isAttached() && eight.isAttached() && !nine.isAttached() && !empty.isAttached());
+  NavIC_CUSTOM unused, built(navic, "PABCDEFG", 1), builtTooLong(navic, "PABCDEFGH", 1);
+  CHECK(!unused.isAttached() && built.isAttached() && !builtTooLong.isAttached());
+
+  std::string text = nmea("GNRMC,123519.00,A,4807.038,N,01131.000,E,022.4,084.4,230394,,,A") +
+                     nmea("PABCDEFG,xyz") + nmea("PABCDEFGH,xyz");
+  navic.encode(text.data(), text.size());
+  CHECK(standard.isUpdated() && strcmp(standard.value(), "A") == 0);
+  CHECK(eight.isUpdated() && strcmp(eight.value(), "xyz") == 0);
+  CHECK(!nine.isValid());
+  CHECK(built.isUpdated() && strcmp(built.value(), "xyz") == 0);
+  CHECK(!builtTooLong.isValid());
+
+  return navic_test_result();
+}
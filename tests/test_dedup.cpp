@@ -0,0 +1,64 @@
+/*
+test_dedup - navic_sentence_cache skips repeats but not parts of a GSV cycle
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_dedup.h"
+#include "navic_rmc_gga++.h"
+#include "navic_test.h"
+
+namespace
+{
+void feed(navic_gn_rmc_gga &navic, const std::string &text)
+{
+  navic.encode(text.data(), text.size());
+}
+
+// SNR of the satellite with this PRN, 0 if not in view
+unsigned snrOf(navic_gn_rmc_gga &navic, uint8_t prn)
+{
+  NavIC_satellites_in_view &view = navic.satellitesInView;
+  for (uint8_t i = 0; i < view.count(); ++i)
+    if (view.prn(i) == prn)
+      return view.snr(i);
+  return 0;
+}
+}
+
+int main()
+{
+  const std::string rmc = nmea("GNRMC,123519.00,A,4807.038,N,01131.000,E,022.4,084.4,230394,,,A");
+  const std::string part2 = nmea("GPGSV,2,2,05,05,40,083,40");
+  const std::string single = nmea("GLGSV,1,1,01,65,20,100,30");
+
+  navic_sentence_cache cache;
+  navic_gn_rmc_gga navic;
+  navic.dedup(&cache);
+
+  // Part 1 changes an SNR from 46 to 47 while part 2 repeats: the cycle
+  // must still complete
+  feed(navic, nmea("GPGSV,2,1,05,01,10,020,46,02,20,040,41,03,30,060,42,04,35,080,43") + part2);
+  CHECK(snrOf(navic, 1) == 46);
+  feed(navic, nmea("GPGSV,2,1,05,01,10,020,47,02,20,040,41,03,30,060,42,04,35,080,43") + part2);
+  CHECK(snrOf(navic, 1) == 47);
+  CHECK(snrOf(navic, 5) == 40);
+  CHECK(cache.suppressed() == 0);
+
+  // Whole sentences, a single-part GSV among them, are still skipped
+  uint32_t passed = navic.passedChecksum();
+  feed(navic, rmc + single);
+  feed(navic, rmc + single);
+  CHECK(cache.suppressed() == 2);
+  CHECK(navic.passedChecksum() == passed + 2);
+  CHECK(snrOf(navic, 65) == 30);
+
+  return navic_test_result();
+}
@@ -0,0 +1,189 @@
+/*
+test_digits - the navic_digits.h term parsers, NavIC_number and the
+parser's term paths agree on awkward terms however they arrive
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_digits.h"
+#include "navic_test.h"
+
+namespace
+{
+// A term followed by ',' and then digits, so that a parser reading past
+// the delimiter shows; 8 readable bytes follow it as Padded requires
+struct padded
+{
+  char buf[64];
+  explicit padded(const char *term)
+  {
+    snprintf(buf, sizeof(buf), "%s,99999999", term);
+  }
+};
+
+int32_t decimal(const char *term, uint8_t places)
+{
+  int32_t unpadded = navic_parse_decimal<false>(padded(term).buf, places);
+  int32_t value = navic_parse_decimal<true>(padded(term).buf, places);
+  CHECK(unpadded == value);
+  return value;
+}
+
+uint32_t whole(const char *term)
+{
+  padded a(term), b(term);
+  const char *p = a.buf, *q = b.buf;
+  uint32_t unpadded = navic_parse_uint<false>(p);
+  uint32_t value = navic_parse_uint<true>(q);
+  CHECK(unpadded == value && p - a.buf == q - b.buf && *q == ',');
+  return value;
+}
+
+RawDegrees nmeaDegrees(const char *term)
+{
+  RawDegrees unpadded, value;
+  navic_parse_degrees<false>(padded(term).buf, unpadded);
+  navic_parse_degrees<true>(padded(term).buf, value);
+  CHECK(unpadded.deg == value.deg && unpadded.billionths == value.billionths);
+  return value;
+}
+
+// A term as navic_gn_rmc_gga reads it a character at a time
+NavIC_number incremental(const char *term)
+{
+  NavIC_number num;
+  num.reset();
+  for (; *term; ++term)
+    num.add(*term);
+  num.finish();
+  return num;
+}
+
+bool same(const NavIC_number &a, const NavIC_number &b)
+{
+  return a.whole == b.whole && a.fraction == b.fraction && a.negative == b.negative;
+}
+
+// The same fix fed whole, split at every offset, and a byte at a time
+struct split
+{
+  std::string text;
+  NavIC_fix whole;
+
+  explicit split(const std::string &sentences) : text(sentences)
+  {
+    navic_gn_rmc_gga navic;
+    navic.encode(text.data(), text.size());
+    navic.snapshot(whole);
+  }
+
+  bool matches(navic_gn_rmc_gga &navic) const
+  {
+    NavIC_fix fix;
+    navic.snapshot(fix);
+    return fix.fields == whole.fields && fix.lat.deg == whole.lat.deg && fix.lat.billionths == whole.lat.billionths &&
+           fix.lat.negative == whole.lat.negative && fix.lng.deg == whole.lng.deg &&
+           fix.lng.billionths == whole.lng.billionths && fix.lng.negative == whole.lng.negative &&
+           fix.date == whole.date && fix.time == whole.time && fix.speed == whole.speed && fix.course == whole.course &&
+           fix.altitude == whole.altitude && fix.satellites == whole.satellites && fix.hdop == whole.hdop;
+  }
+
+  void check() const
+  {
+    for (size_t at = 0; at <= text.size(); ++at)
+    {
+      navic_gn_rmc_gga navic;
+      navic.encode(text.data(), at);
+      navic.encode(text.data() + at, text.size() - at);
+      CHECK(matches(navic));
+    }
+    navic_gn_rmc_gga bytes;
+    for (size_t i = 0; i < text.size(); ++i)
+      bytes.encode(text[i]);
+    CHECK(matches(bytes));
+  }
+};
+}
+
+int main()
+{
+  // Empty terms, and terms with no digits
+  CHECK(decimal("", 2) == 0);
+  CHECK(decimal("-", 2) == 0);
+  CHECK(decimal(".", 2) == 0);
+  CHECK(whole("") == 0);
+  CHECK(nmeaDegrees("").deg == 0 && nmeaDegrees("").billionths == 0);
+
+  // More than 8 digits, either side of the point
+  CHECK(whole("123456789") == 123456789);
+  CHECK(whole("4294967295") == 4294967295U);
+  CHECK(decimal("1234567.891", 2) == 123456789);
+  CHECK(decimal("0.123456789", 7) == 1234567);
+  CHECK(decimal("12.3456789012", 2) == 1234);
+  CHECK(decimal("-98765.4321", 3) == -98765432);
+
+  // Leading and trailing points
+  CHECK(decimal(".5", 2) == 50);
+  CHECK(decimal("-.5", 2) == -50);
+  CHECK(decimal("12.", 2) == 1200);
+  CHECK(decimal("-12.", 1) == -120);
+  CHECK(decimal("7.5.3", 2) == 750);
+
+  // NMEA degrees
+  RawDegrees lat = nmeaDegrees("4807.038");
+  CHECK(lat.deg == 48 && lat.billionths == 117300000);
+  RawDegrees lng = nmeaDegrees("01131.00012345678");
+  CHECK(lng.deg == 11 && lng.billionths == 516668723);
+  CHECK(nmeaDegrees(".5").deg == 0 && nmeaDegrees(".5").billionths == 8333333);
+
+  // NavIC_number fed a character at a time, as _NavIC_INCREMENTAL_TERMS
+  // reads, against navic_parse_number() on the whole term, padded or not
+  const char alphabet[] = "0123456789.-x";
+  uint32_t state = 1;
+  for (int i = 0; i < 20000; ++i)
+  {
+    char term[20];
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    size_t length = state % 17;
+    for (size_t j = 0; j < length; ++j)
+    {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      // mostly digits, so that long numbers come up
+      term[j] = state % 4 ? alphabet[state % 10] : alphabet[state % 13];
+    }
+    term[length] = 0;
+    NavIC_number byChar = incremental(term), unpadded, value;
+    navic_parse_number<false>(padded(term).buf, unpadded, _NavIC_FRACTION_DIGITS);
+    navic_parse_number<true>(padded(term).buf, value, _NavIC_FRACTION_DIGITS);
+    CHECK(same(byChar, value) && same(unpadded, value));
+    CHECK(byChar.hundredths() == decimal(term, 2));
+  }
+
+  // Whole sentences split across encode() calls at every offset, so each
+  // term is read in place (padded or at the buffer's end), across two
+  // buffers, and a byte at a time; terms are at most 14 characters, the
+  // longest a byte-fed term keeps
+  split edges(nmea("GPRMC,123519.1234567,A,4807.038123456,S,01131.0001,W,.5,12.,230394,,,A") +
+              nmea("GPGGA,123520.00,4807.038,N,01131.000,E,1,12,0.9,-.5,M,46.9,M,,"));
+  CHECK(edges.whole.speed == 50 && edges.whole.course == 1200 && edges.whole.altitude == -50);
+  CHECK(edges.whole.date == 230394 && edges.whole.time == 12352000 && edges.whole.hdop == 90);
+  edges.check();
+  split(nmea("GNRMC,000000.00,A,0000.0000,N,00000.0000,E,,,010100,,,A") +
+        nmea("GNGGA,000001.,0000.,N,00000.,E,6,,,,M,,M,,"))
+      .check();
+  split(nmea("GPGGA,235959.99,8959.9999999,N,17959.9999999,W,2,99,99.99,99999.99,M,,M,,"))
+      .check();
+
+  return navic_test_result();
+}
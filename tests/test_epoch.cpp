@@ -0,0 +1,125 @@
+/*
+test_epoch - navic_epoch_assembler emits each UTC time once, in order
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_epoch.h"
+#include "navic_test.h"
+
+#include <vector>
+
+namespace
+{
+std::vector<NavIC_epoch> epochs;
+
+void collect(const NavIC_epoch &epoch, void *)
+{
+  epochs.push_back(epoch);
+}
+
+NavIC_fix commit(uint8_t sentence, uint32_t time)
+{
+  NavIC_fix fix;
+  fix.time = time;
+  fix.sentence = sentence;
+  fix.committed = fix.fields = NavIC_fix::TIME | NavIC_fix::LOCATION;
+  return fix;
+}
+
+const uint8_t RMC = navic_gn_rmc_gga::NAVIC_SENTENCE_RMC;
+const uint8_t GGA = navic_gn_rmc_gga::NAVIC_SENTENCE_GGA;
+}
+
+int main()
+{
+  // Out of order: the GGA of an epoch already emitted is late, and must
+  // neither emit that epoch again nor cut the open one short
+  navic_epoch_assembler epoch;
+  epoch.begin(collect);
+  epoch.update(commit(RMC, 100));
+  epoch.update(commit(RMC, 200));
+  epoch.update(commit(GGA, 100));
+  CHECK(epochs.size() == 1);
+  CHECK(epoch.late() == 1);
+  epoch.update(commit(GGA, 200));
+  CHECK(epochs.size() == 2);
+  CHECK(epochs[0].fix.time == 100 && !epochs[0].complete);
+  CHECK(epochs[1].fix.time == 200 && epochs[1].complete);
+
+  // Older than the open epoch, though never emitted, is late too
+  epoch.update(commit(RMC, 400));
+  epoch.update(commit(GGA, 300));
+  epoch.update(commit(GGA, 400));
+  CHECK(epochs.size() == 3);
+  CHECK(epochs[2].fix.time == 400 && epochs[2].complete);
+  CHECK(epoch.late() == 2);
+
+  // Repeats of the last epoch emitted
+  epoch.update(commit(RMC, 400));
+  epoch.update(commit(GGA, 400));
+  CHECK(epochs.size() == 3);
+  CHECK(epoch.late() == 4);
+
+  // Each time went out once
+  for (size_t i = 0; i < epochs.size(); ++i)
+    for (size_t j = i + 1; j < epochs.size(); ++j)
+      CHECK(epochs[i].fix.time != epochs[j].fix.time);
+  CHECK(epoch.emitted() == epochs.size());
+
+  // Midnight: 00:00:00 comes after 23:59:59
+  epochs.clear();
+  navic_epoch_assembler midnight;
+  midnight.begin(collect);
+  midnight.update(commit(RMC, 23595900));
+  midnight.update(commit(GGA, 23595900));
+  midnight.update(commit(RMC, 0));
+  midnight.update(commit(GGA, 23595900));
+  midnight.update(commit(GGA, 0));
+  CHECK(epochs.size() == 2);
+  CHECK(epochs[0].fix.time == 23595900 && epochs[1].fix.time == 0 && epochs[1].complete);
+  CHECK(midnight.late() == 1);
+
+  // A receiver cold-starting back to 00:00:00 restarts the order rather
+  // than having every later epoch dropped as late
+  epochs.clear();
+  navic_epoch_assembler restart;
+  restart.begin(collect);
+  restart.update(commit(RMC, 12000000));
+  restart.update(commit(GGA, 12000000));
+  restart.update(commit(RMC, 0));
+  restart.update(commit(GGA, 0));
+  restart.update(commit(RMC, 100));
+  restart.update(commit(GGA, 100));
+  CHECK(epochs.size() == 3);
+  CHECK(epochs[1].fix.time == 0 && epochs[1].complete);
+  CHECK(epochs[2].fix.time == 100 && epochs[2].complete);
+  CHECK(restart.late() == 0 && restart.resyncs() == 1);
+
+  // One sentence with a time jumped forward costs that epoch only
+  epochs.clear();
+  restart.update(commit(RMC, 3000000));
+  restart.update(commit(RMC, 200));
+  restart.update(commit(GGA, 200));
+  CHECK(epochs.size() == 2);
+  CHECK(epochs[0].fix.time == 3000000 && !epochs[0].complete);
+  CHECK(epochs[1].fix.time == 200 && epochs[1].complete);
+  CHECK(restart.resyncs() == 2);
+
+  // begin() again forgets the order as well
+  epochs.clear();
+  restart.begin(collect);
+  restart.update(commit(RMC, 100));
+  restart.update(commit(GGA, 100));
+  CHECK(epochs.size() == 1 && epochs[0].complete);
+  CHECK(restart.late() == 0);
+
+  return navic_test_result();
+}
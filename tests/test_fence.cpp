@@ -0,0 +1,85 @@
+/*
+test_fence - navic_fence_index against distanceBetween(), up to the poles
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_fence.h"
+#include "navic_test.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+namespace
+{
+double uniform()
+{
+  return rand() / (double)RAND_MAX * 2 - 1;
+}
+
+// Points around one fence; the index may only disagree with
+// distanceBetween() right at the edge
+void compare(double lat, double lng, uint32_t radius, uint32_t cellMeters)
+{
+  navic_fence_index index(cellMeters);
+  index.add(7, (int32_t)lround(lat * 1e7), (int32_t)lround(lng * 1e7), radius);
+  index.build();
+
+  double reach = 1.2 * radius / 111000.0;
+  double c = cos(lat * DEG_TO_RAD);
+  unsigned wrong = 0;
+  std::vector<uint32_t> ids;
+  for (int i = 0; i < 20000; ++i)
+  {
+    double pLat = lat + uniform() * reach;
+    if (pLat > 90)
+      pLat = 180 - pLat;
+    double pLng = lng + uniform() * reach / (c > 0.02 ? c : 0.02);
+    int32_t latE7 = (int32_t)lround(pLat * 1e7), lngE7 = (int32_t)lround(pLng * 1e7);
+    double d = navic_gn_rmc_gga::distanceBetween(latE7 / 1e7, lngE7 / 1e7, lat, lng);
+    ids.clear();
+    bool inside = index.query(latE7, lngE7, ids) == 1;
+    if (inside != (d <= radius) && fabs(d - radius) > 3e-4 * radius + 0.01)
+      ++wrong;
+  }
+  if (wrong != 0)
+    fprintf(stderr, "lat %g radius %u: %u points misplaced\n", lat, radius, wrong);
+  CHECK(wrong == 0);
+}
+}
+
+int main()
+{
+  const double lats[] = {0, 45, 70, 79, 84, 86, 88, 89.9, -89.9};
+  const uint32_t radii[] = {50, 1000, 20000};
+  for (size_t i = 0; i < sizeof(lats) / sizeof(lats[0]); ++i)
+    for (size_t j = 0; j < sizeof(radii) / sizeof(radii[0]); ++j)
+    {
+      compare(lats[i], 10, radii[j], _NavIC_FENCE_CELL_METERS);
+      compare(lats[i], 179.99, radii[j], radii[j]);
+    }
+  compare(60, 10, 100000, 100000);
+
+  // Fences reaching a pole or spanning far more than a cell are kept
+  // aside rather than copied into every column
+  navic_fence_index index;
+  index.add(1, 890000000, 0, 200000);
+  index.add(2, 0, 0, 5000000);
+  index.add(3, 100000, 100000, 500);
+  index.build();
+  std::vector<uint32_t> ids;
+  CHECK(index.query(900000000, 1234567890, ids) == 1 && ids[0] == 1);
+  ids.clear();
+  CHECK(index.query(100000, 100000, ids) == 2);
+  ids.clear();
+  CHECK(index.query(-400000000, 0, ids) == 1 && ids[0] == 2);
+
+  return navic_test_result();
+}
@@ -0,0 +1,224 @@
+/*
+test_geo - the batch geodesy in navic_geo.h and the integer E7 helpers
+against distanceBetween() and courseTo(), on random pairs and across the
+antimeridian and the poles
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_geo.h"
+#include "navic_test.h"
+
+#include <math.h>
+#include <vector>
+
+namespace
+{
+// Tolerances of the batch kernels against the scalar functions
+const double preciseMeters = 0.001;
+const double preciseDegrees = 1e-4; // course only, which is ill-conditioned below a meter
+const double fastMeters = 5;
+const double fastDegrees = 0.001;
+// and of distanceBetweenE7() and courseToE7(), as navic_rmc_gga++.h states
+const double e7Centimeters = 5;
+const double e7Fraction = 0.0003;
+const double e7CentiDegrees = 20; // beyond 10 m
+
+uint32_t state = 1;
+
+double uniform(double lo, double hi)
+{
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return lo + (hi - lo) * (state / 4294967296.0);
+}
+
+int32_t e7(double degrees)
+{
+  return (int32_t)lround(degrees * 1e7);
+}
+
+// Absolute difference of two courses in degrees, across north
+double courseError(double a, double b)
+{
+  double d = fabs(a - b);
+  return d > 180 ? 360 - d : d;
+}
+
+struct pairs
+{
+  std::vector<double> lat1, lng1, lat2, lng2;
+
+  void add(double a, double b, double c, double d)
+  {
+    lat1.push_back(a);
+    lng1.push_back(b);
+    lat2.push_back(c);
+    lng2.push_back(d);
+  }
+
+  size_t size() const { return lat1.size(); }
+
+  // Each pair through both batches at one accuracy, the first n of them
+  void check(NavIC_geo_accuracy accuracy, size_t n, double meters, double degrees) const
+  {
+    std::vector<double> distance(n + 1, -1), course(n + 1, -1);
+    navic_distance_batch(&lat1[0], &lng1[0], &lat2[0], &lng2[0], &distance[0], n, accuracy);
+    navic_course_batch(&lat1[0], &lng1[0], &lat2[0], &lng2[0], &course[0], n, accuracy);
+    for (size_t i = 0; i < n; ++i)
+    {
+      double d = navic_gn_rmc_gga::distanceBetween(lat1[i], lng1[i], lat2[i], lng2[i]);
+      CHECK(fabs(distance[i] - d) <= meters);
+      if (d > 1)
+        CHECK(courseError(course[i], navic_gn_rmc_gga::courseTo(lat1[i], lng1[i], lat2[i], lng2[i])) <= degrees);
+      CHECK(course[i] >= 0 && course[i] < 360);
+    }
+    // nothing written past the end
+    CHECK(distance[n] == -1 && course[n] == -1);
+  }
+
+  // Each pair, as read to 10^-7 degree, through the E7 helpers
+  void checkE7() const
+  {
+    for (size_t i = 0; i < size(); ++i)
+    {
+      int32_t a = e7(lat1[i]), b = e7(lng1[i]), c = e7(lat2[i]), d = e7(lng2[i]);
+      double meters = navic_gn_rmc_gga::distanceBetween(a / 1e7, b / 1e7, c / 1e7, d / 1e7);
+      CHECK(fabs(navic_gn_rmc_gga::distanceBetweenE7(a, b, c, d) - meters * 100) <= e7Centimeters + e7Fraction * meters * 100);
+      uint16_t course = navic_gn_rmc_gga::courseToE7(a, b, c, d);
+      CHECK(course < 36000);
+      // from a pole the course depends on the longitude given for it
+      if (meters > 10 && a != 900000000 && a != -900000000)
+        CHECK(courseError(course / 100.0, navic_gn_rmc_gga::courseTo(a / 1e7, b / 1e7, c / 1e7, d / 1e7)) <= e7CentiDegrees / 100.0);
+    }
+  }
+};
+}
+
+int main()
+{
+  const double halfWay = 6372795.0 * M_PI;
+  pairs edge;
+  edge.add(12.9716, 77.5946, 12.9716, 77.5946);      // coincident
+  edge.add(-33.5, -70.25, -33.5, -70.25);
+  edge.add(10, 179.9995, 10, -179.9995);             // across the antimeridian
+  edge.add(-45, -179.99, -45.01, 179.99);
+  edge.add(0, 180, 0, -180);                         // the same point, twice
+  edge.add(89.9, 10, 90, 10);                        // onto the north pole
+  edge.add(89.9, 10, 90, 0);
+  edge.add(90, 0, 89, 50);                           // away from it
+  edge.add(-90, 0, -89.5, -120);
+  edge.add(89.995, 0, 89.995, 180);                  // over it
+  edge.add(90, 0, -90, 0);                           // pole to pole
+  edge.add(0, 0, 0, 180);                            // antipodes
+
+  std::vector<double> distance(edge.size()), course(edge.size());
+  navic_distance_batch(&edge.lat1[0], &edge.lng1[0], &edge.lat2[0], &edge.lng2[0], &distance[0], edge.size());
+  navic_course_batch(&edge.lat1[0], &edge.lng1[0], &edge.lat2[0], &edge.lng2[0], &course[0], edge.size());
+  CHECK(distance[0] < 1e-6 && course[0] == 0);
+  CHECK(distance[1] < 1e-6 && course[1] == 0);
+  CHECK(fabs(distance[2] - 109.5) < 0.5 && fabs(course[2] - 90) < 0.01);
+  CHECK(distance[4] < preciseMeters);
+  CHECK(courseError(course[5], 0) < preciseDegrees && courseError(course[6], 0) < preciseDegrees);
+  CHECK(fabs(distance[5] - distance[6]) < preciseMeters);
+  CHECK(fabs(distance[9] - distance[5] / 10) < preciseMeters); // 0.01 degree of arc
+  CHECK(fabs(distance[10] - halfWay) < preciseMeters && fabs(distance[11] - halfWay) < preciseMeters);
+  edge.check(NAVIC_GEO_PRECISE, edge.size(), preciseMeters, preciseDegrees);
+  edge.check(NAVIC_GEO_FAST, edge.size(), fastMeters, fastDegrees);
+
+  // Random pairs anywhere, and as often a few centimeters to a degree apart;
+  // the first few counts leave the vector loops a partial tail
+  pairs random;
+  for (int i = 0; i < 20000; ++i)
+  {
+    double lat = uniform(-90, 90), lng = uniform(-180, 180);
+    if (i % 2)
+      random.add(lat, lng, uniform(-90, 90), uniform(-180, 180));
+    else
+    {
+      double span = pow(10, uniform(-6, 0));
+      double lat2 = lat + uniform(-span, span);
+      double lng2 = lng + uniform(-span, span);
+      random.add(lat, lng, lat2 > 90 ? 90 : lat2 < -90 ? -90 : lat2, lng2 > 180 ? lng2 - 360 : lng2 < -180 ? lng2 + 360 : lng2);
+    }
+  }
+  for (size_t n = 0; n < 10; ++n)
+    random.check(NAVIC_GEO_PRECISE, n, preciseMeters, preciseDegrees);
+  random.check(NAVIC_GEO_PRECISE, random.size(), preciseMeters, preciseDegrees);
+  random.check(NAVIC_GEO_FAST, random.size(), fastMeters, fastDegrees);
+
+  // The E7 helpers on the same edges, less those more than a degree apart,
+  // and on pairs up to a degree apart anywhere, a third of them within a
+  // few degrees of a pole
+  pairs nearby;
+  for (size_t i = 0; i < 10; ++i)
+    nearby.add(edge.lat1[i], edge.lng1[i], edge.lat2[i], edge.lng2[i]);
+  nearby.add(-89.9, -170, -90, 10);
+  nearby.add(-89.995, 90, -89.995, -90);
+  nearby.checkE7();
+  CHECK(navic_gn_rmc_gga::distanceBetweenE7(e7(12.9716), e7(77.5946), e7(12.9716), e7(77.5946)) == 0);
+  CHECK(navic_gn_rmc_gga::courseToE7(e7(12.9716), e7(77.5946), e7(12.9716), e7(77.5946)) == 0);
+  CHECK(navic_gn_rmc_gga::courseToE7(e7(10), e7(179.9995), e7(10), e7(-179.9995)) == 9000);
+  CHECK(navic_gn_rmc_gga::courseToE7(e7(10), e7(-179.9995), e7(10), e7(179.9995)) == 27000);
+  CHECK(navic_gn_rmc_gga::distanceBetweenE7(e7(89.9), e7(10), e7(90), e7(10)) ==
+        navic_gn_rmc_gga::distanceBetweenE7(e7(89.9), e7(10), e7(90), e7(-123)));
+  CHECK(navic_gn_rmc_gga::courseToE7(e7(89.9), e7(10), e7(90), e7(-123)) == 0);
+  CHECK(navic_gn_rmc_gga::courseToE7(e7(90), e7(0), e7(89), e7(50)) == 18000);
+  CHECK(navic_gn_rmc_gga::courseToE7(e7(-90), e7(0), e7(-89.5), e7(-120)) == 0);
+  uint32_t over = navic_gn_rmc_gga::courseToE7(e7(89.995), e7(0), e7(89.995), e7(180));
+  CHECK(over <= 1 || over >= 35999);
+  over = navic_gn_rmc_gga::courseToE7(e7(-89.995), e7(90), e7(-89.995), e7(-90));
+  CHECK(over >= 17999 && over <= 18001);
+
+  pairs local;
+  for (int i = 0; i < 30000; ++i)
+  {
+    double lat = i % 3 ? uniform(-90, 90) : (90 - pow(10, uniform(-3, 1))) * (i % 2 ? 1 : -1);
+    double lng = uniform(-180, 180);
+    double span = pow(10, uniform(-6, 0));
+    double lat2 = lat + uniform(-span, span);
+    double lng2 = lng + uniform(-span, span);
+    // past a pole is down the other side
+    if (lat2 > 90 || lat2 < -90)
+    {
+      lat2 = (lat2 > 0 ? 180 : -180) - lat2;
+      lng2 += 180;
+    }
+    local.add(lat, lng, lat2, lng2 > 180 ? lng2 - 360 : lng2 < -180 ? lng2 + 360 : lng2);
+  }
+  local.checkE7();
+
+  // A track a little over two blocks long, every length up to it
+  std::vector<double> lat, lng;
+  lat.push_back(12.9716);
+  lng.push_back(77.5946);
+  for (int i = 1; i < 600; ++i)
+  {
+    lat.push_back(lat.back() + uniform(-0.001, 0.001));
+    lng.push_back(lng.back() + uniform(-0.001, 0.001));
+  }
+  std::vector<double> segments(lat.size());
+  double length = 0;
+  for (size_t n = 0; n <= lat.size(); ++n)
+  {
+    if (n >= 2)
+      length += navic_gn_rmc_gga::distanceBetween(lat[n - 2], lng[n - 2], lat[n - 1], lng[n - 1]);
+    if (n != 0 && n != 1 && n != 2 && n != 256 && n != 257 && n != 258 && n != 513 && n != lat.size())
+      continue;
+    CHECK(fabs(navic_track_length(&lat[0], &lng[0], n) - length) <= n * preciseMeters);
+    CHECK(fabs(navic_track_length(&lat[0], &lng[0], n, NAVIC_GEO_FAST) - length) <= n * fastMeters);
+  }
+  navic_track_segments(&lat[0], &lng[0], lat.size(), &segments[0]);
+  for (size_t i = 0; i + 1 < lat.size(); ++i)
+    CHECK(fabs(segments[i] - navic_gn_rmc_gga::distanceBetween(lat[i], lng[i], lat[i + 1], lng[i + 1])) <= preciseMeters);
+
+  return navic_test_result();
+}
@@ -0,0 +1,71 @@
+/*
+test_listener - NavIC_LISTENER ending itself and outliving its parser
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_epoch.h"
+#include "navic_test.h"
+
+namespace
+{
+struct Counter
+{
+  unsigned calls;
+  NavIC_LISTENER *endOnCall;
+};
+
+void count(const NavIC_fix &, void *context)
+{
+  Counter *c = (Counter *)context;
+  ++c->calls;
+  if (c->endOnCall != NULL)
+    c->endOnCall->end();
+}
+
+void ignore(const NavIC_epoch &, void *)
+{
+}
+}
+
+int main()
+{
+  const std::string rmc = nmea("GNRMC,123519.00,A,4807.038,N,01131.000,E,022.4,084.4,230394,,,A");
+
+  // The first listener called (the last attached) ends itself; the walk
+  // must still reach the other
+  {
+    navic_gn_rmc_gga navic;
+    Counter other = {0, NULL}, self = {0, NULL};
+    NavIC_LISTENER otherListener(navic, count, &other);
+    NavIC_LISTENER selfListener(navic, count, &self);
+    self.endOnCall = &selfListener;
+    navic.encode(rmc.data(), rmc.size());
+    navic.encode(rmc.data(), rmc.size());
+    CHECK(self.calls == 1);
+    CHECK(other.calls == 2);
+  }
+
+  // Listeners, and the assembler holding one, outlive their parser
+  {
+    Counter c = {0, NULL};
+    NavIC_LISTENER listener;
+    navic_epoch_assembler epochs;
+    navic_gn_rmc_gga *navic = new navic_gn_rmc_gga;
+    listener.begin(*navic, count, &c);
+    epochs.begin(*navic, ignore);
+    navic->encode(rmc.data(), rmc.size());
+    delete navic;
+    CHECK(c.calls == 1);
+    listener.end();
+  }
+
+  return navic_test_result();
+}
@@ -0,0 +1,86 @@
+/*
+test_parser - navic_parser<Fields> commits what navic_gn_rmc_gga does for
+the fields it keeps
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_parser.h"
+#include "navic_corpus.h"
+#include "navic_test.h"
+
+namespace
+{
+bool same(const RawDegrees &a, const RawDegrees &b)
+{
+  return a.deg == b.deg && a.billionths == b.billionths && a.negative == b.negative;
+}
+
+// Feeds the corpus to both parsers in the same chunks of 1 to 200 bytes,
+// so terms and sentences split anywhere, and compares after each chunk
+template <uint8_t Fields>
+void compare(const std::string &corpus)
+{
+  navic_gn_rmc_gga navic;
+  navic_parser<Fields> parser;
+  navic_corpus_random random(Fields);
+  unsigned commits = 0;
+  for (size_t at = 0; at < corpus.size();)
+  {
+    size_t len = 1 + random.below(200);
+    if (len > corpus.size() - at)
+      len = corpus.size() - at;
+    navic.encode(corpus.data() + at, len);
+    parser.encode(corpus.data() + at, len);
+    at += len;
+
+    NavIC_fix expected, got;
+    navic.snapshot(expected);
+    parser.snapshot(got);
+    CHECK((expected.fields & Fields) == parser.fields());
+    if (expected.sentence == navic_gn_rmc_gga::NAVIC_SENTENCE_RMC || expected.sentence == navic_gn_rmc_gga::NAVIC_SENTENCE_GGA)
+    {
+      CHECK((expected.committed & Fields) == parser.committed());
+      commits += expected.committed != 0;
+    }
+    if (Fields & NavIC_fix::LOCATION)
+      CHECK(same(expected.lat, got.lat) && same(expected.lng, got.lng));
+    if (Fields & NavIC_fix::DATE)
+      CHECK(expected.date == got.date);
+    if (Fields & NavIC_fix::TIME)
+      CHECK(expected.time == got.time);
+    if (Fields & NavIC_fix::SPEED)
+      CHECK(expected.speed == got.speed);
+    if (Fields & NavIC_fix::COURSE)
+      CHECK(expected.course == got.course);
+    if (Fields & NavIC_fix::ALTITUDE)
+      CHECK(expected.altitude == got.altitude);
+    if (Fields & NavIC_fix::SATELLITES)
+      CHECK(expected.satellites == got.satellites);
+    if (Fields & NavIC_fix::HDOP)
+      CHECK(expected.hdop == got.hdop);
+  }
+  CHECK(commits > 100);
+  CHECK(navic.passedChecksum() == parser.passedChecksum());
+  CHECK(navic.failedChecksum() == parser.failedChecksum());
+  CHECK(navic.charsProcessed() == parser.charsProcessed());
+}
+}
+
+int main()
+{
+  // the benchmark corpus: bad checksums and sentences cut short included
+  navic_corpus corpus(3);
+  std::string text = corpus.generate(600);
+  compare<0xFF>(text);
+  compare<NavIC_fix::TIME | NavIC_fix::LOCATION>(text);
+  compare<NavIC_fix::ALTITUDE>(text);
+  return navic_test_result();
+}
@@ -0,0 +1,104 @@
+/*
+test_pool - navic_stream_pool keeps each stream as its own
+navic_gn_rmc_gga would
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_pool.h"
+#include "navic_corpus.h"
+#include "navic_test.h"
+
+#include <vector>
+
+namespace
+{
+const uint32_t STREAMS = 8;
+
+bool same(const RawDegrees &a, const RawDegrees &b)
+{
+  return a.deg == b.deg && a.billionths == b.billionths && a.negative == b.negative;
+}
+
+void compare(const navic_stream_pool &pool, uint32_t stream, const navic_gn_rmc_gga &navic)
+{
+  const NavIC_fix &got = pool.fix(stream);
+  NavIC_fix expected;
+  navic.snapshot(expected);
+  CHECK(got.fields == expected.fields);
+  if (expected.sentence == navic_gn_rmc_gga::NAVIC_SENTENCE_RMC || expected.sentence == navic_gn_rmc_gga::NAVIC_SENTENCE_GGA)
+    CHECK(got.committed == expected.committed && got.sentence == expected.sentence && got.talker == expected.talker);
+  if (expected.fields & NavIC_fix::LOCATION)
+    CHECK(same(got.lat, expected.lat) && same(got.lng, expected.lng));
+  if (expected.fields & NavIC_fix::DATE)
+    CHECK(got.date == expected.date);
+  if (expected.fields & NavIC_fix::TIME)
+    CHECK(got.time == expected.time);
+  if (expected.fields & NavIC_fix::SPEED)
+    CHECK(got.speed == expected.speed && got.course == expected.course);
+  if (expected.fields & NavIC_fix::ALTITUDE)
+    CHECK(got.altitude == expected.altitude);
+  if (expected.fields & NavIC_fix::SATELLITES)
+    CHECK(got.satellites == expected.satellites && got.hdop == expected.hdop);
+  CHECK(pool.passedChecksum(stream) == navic.passedChecksum());
+  CHECK(pool.failedChecksum(stream) == navic.failedChecksum());
+  CHECK(pool.charsProcessed(stream) == navic.charsProcessed());
+}
+}
+
+int main()
+{
+  // Each stream its own receiver; buffers of 1 to 300 bytes from the
+  // streams in turn at random, as a reactor would hand them over
+  navic_stream_pool pool(STREAMS);
+  std::vector<navic_gn_rmc_gga> parsers(STREAMS);
+  std::vector<std::string> corpora;
+  std::vector<size_t> at(STREAMS, 0);
+  for (uint32_t stream = 0; stream < STREAMS; ++stream)
+  {
+    navic_corpus corpus(stream + 1);
+    corpora.push_back(corpus.generate(200 + 20 * stream));
+  }
+  navic_corpus_random random(11);
+  for (uint32_t left = STREAMS; left != 0;)
+  {
+    uint32_t stream = random.below(STREAMS);
+    const std::string &text = corpora[stream];
+    if (at[stream] == text.size())
+      continue;
+    size_t len = 1 + random.below(300);
+    if (len > text.size() - at[stream])
+      len = text.size() - at[stream];
+    pool.encode(stream, text.data() + at[stream], len);
+    parsers[stream].encode(text.data() + at[stream], len);
+    at[stream] += len;
+    left -= at[stream] == text.size();
+    compare(pool, stream, parsers[stream]);
+  }
+  for (uint32_t stream = 0; stream < STREAMS; ++stream)
+    CHECK(pool.fix(stream).fields == 0xFF);
+
+  // An RMC of more than 255 terms: the term count must not wrap and read
+  // term 256 as the sentence name
+  std::string body = "GPRMC,120000.00,A,1300.000,N,07700.000,E,1.0,45.0,010126";
+  for (int i = 10; i < 256; ++i)
+    body += ",";
+  body += ",GPTXT,x";
+  std::string text = nmea(body);
+  pool.reset(0);
+  navic_gn_rmc_gga navic;
+  pool.encode(0, text.data(), text.size());
+  navic.encode(text.data(), text.size());
+  CHECK(pool.fix(0).time == 12000000 && pool.fix(0).sentence == navic_gn_rmc_gga::NAVIC_SENTENCE_RMC);
+  CHECK(pool.passedChecksum(0) == 1);
+  compare(pool, 0, navic);
+
+  return navic_test_result();
+}
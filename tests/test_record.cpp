@@ -0,0 +1,74 @@
+/*
+test_record - fixed records and block files, whole and corrupt
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_record.h"
+#include "navic_test.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+int main()
+{
+  NavIC_fix fix;
+  fix.time = 12351900;
+  fix.speed = 2240;
+  fix.fields = fix.committed = NavIC_fix::TIME | NavIC_fix::SPEED;
+
+  // The fixed record has no room for committed: it comes back 0, not
+  // whatever the fix unpacked into held
+  uint8_t record[_NavIC_RECORD_SIZE];
+  navic_record_pack(fix, record);
+  NavIC_fix out;
+  out.committed = 0xff;
+  navic_record_unpack(record, out);
+  CHECK(out.time == fix.time && out.speed == fix.speed && out.fields == fix.fields);
+  CHECK(out.committed == 0);
+
+  char path[] = "/tmp/navic_test_recordXXXXXX";
+  int fd = mkstemp(path);
+  CHECK(fd >= 0);
+  close(fd);
+
+  navic_block_writer writer;
+  CHECK(writer.open(path));
+  for (int i = 0; i < 10; ++i)
+  {
+    fix.time += 100;
+    CHECK(writer.append(fix));
+  }
+  CHECK(writer.close());
+
+  navic_block_reader reader;
+  CHECK(reader.open(path));
+  int n = 0;
+  while (reader.next(out))
+    ++n;
+  CHECK(n == 10);
+  CHECK(out.time == fix.time && out.committed == fix.committed);
+  reader.close();
+
+  // A count the payload cannot hold is refused before anything is
+  // allocated for it
+  FILE *f = fopen(path, "r+b");
+  CHECK(f != NULL);
+  const uint8_t huge[4] = {0xff, 0xff, 0xff, 0x7f};
+  fseek(f, 4, SEEK_SET);
+  fwrite(huge, 1, sizeof(huge), f);
+  fclose(f);
+  CHECK(reader.open(path));
+  CHECK(!reader.next(out));
+  reader.close();
+
+  unlink(path);
+  return navic_test_result();
+}
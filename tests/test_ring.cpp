@@ -0,0 +1,141 @@
+/*
+test_ring - navic_uart_ring hands over whole sentences only, across the
+wrap and when it fills
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_ring.h"
+#include "navic_test.h"
+
+namespace
+{
+// Stands in for a parser: keeps what drain() passes and in how many spans
+struct recorder
+{
+  std::string text;
+  unsigned spans;
+
+  recorder() : spans(0) {}
+  size_t encode(const char *buf, size_t len)
+  {
+    text.append(buf, len);
+    ++spans;
+    return 0;
+  }
+};
+
+std::string sentence(unsigned i, size_t length)
+{
+  char head[16];
+  snprintf(head, sizeof(head), "GPTXT,%02u,", i % 100);
+  std::string body = head;
+  while (body.size() + 6 < length)
+    body += 'x';
+  return nmea(body); // length bytes, '$' to '\n'
+}
+
+// Every line of text is a whole sentence with a good checksum
+bool wholeSentences(const std::string &text)
+{
+  size_t start = 0;
+  while (start < text.size())
+  {
+    size_t end = text.find('\n', start);
+    if (end == std::string::npos)
+      return false;
+    std::string line = text.substr(start, end + 1 - start);
+    size_t star = line.find('*');
+    if (line[0] != '$' || star == std::string::npos || nmea(line.substr(1, star - 1)) != line)
+      return false;
+    start = end + 1;
+  }
+  return true;
+}
+}
+
+int main()
+{
+  // Filling up mid-sentence drops that sentence whole; the next one that
+  // fits after a drain() goes through
+  navic_uart_ring<64> ring;
+  recorder out;
+  std::string a = sentence(1, 30), b = sentence(2, 40), c = sentence(3, 30);
+  CHECK(ring.put(a.data(), a.size()) == a.size());
+  CHECK(ring.put(b.data(), b.size()) < b.size());
+  CHECK(ring.dropped() == 1);
+  CHECK(ring.available() == a.size());
+  ring.drain(out);
+  CHECK(out.text == a);
+  CHECK(ring.put(c.data(), c.size()) == c.size());
+  ring.drain(out);
+  CHECK(out.text == a + c);
+  CHECK(ring.dropped() == 1);
+
+  // Bytes before the first '$' are not kept
+  CHECK(!ring.put('x') && !ring.put('\n'));
+  CHECK(ring.available() == 0);
+
+  // A sentence cut short by the next '$' is passed on for the parser to
+  // count, as a parser fed directly would see it
+  navic_uart_ring<64> cut;
+  recorder cutOut;
+  std::string partial = sentence(4, 20).substr(0, 12), whole = sentence(5, 20);
+  cut.put(partial.data(), partial.size());
+  CHECK(cut.available() == 0);
+  cut.put(whole.data(), whole.size());
+  cut.drain(cutOut);
+  CHECK(cutOut.text == partial + whole);
+
+  // Lengths that do not divide the ring make sentences wrap; every one
+  // comes out whole and in order, some in two spans.  drain() runs every
+  // fifth sentence, so the ring now and then fills.
+  navic_uart_ring<128> wrap;
+  recorder wrapOut;
+  std::string expected;
+  uint32_t dropped = 0;
+  for (unsigned i = 0; i < 400; ++i)
+  {
+    std::string s = sentence(i, 20 + i * 7 % 33);
+    size_t room = wrap.capacity() - wrap.available();
+    if (wrap.put(s.data(), s.size()) == s.size())
+      expected += s;
+    else
+    {
+      CHECK(s.size() > room);
+      CHECK(wrap.dropped() == ++dropped);
+    }
+    if (i % 5 == 4)
+      wrap.drain(wrapOut);
+  }
+  wrap.drain(wrapOut);
+  CHECK(wrapOut.text == expected);
+  CHECK(wholeSentences(wrapOut.text));
+  CHECK(dropped > 0);
+  CHECK(wrapOut.spans > 400 / 5 + 1); // some drains took two spans
+
+  // Through a real parser, dropped sentences never reach the checksum
+  navic_uart_ring<256> feed;
+  navic_gn_rmc_gga navic;
+  std::string rmc = nmea("GPRMC,123519.00,A,4807.038,N,01131.000,E,022.4,084.4,230394,,,A");
+  unsigned passed = 0;
+  for (unsigned i = 0; i < 50; ++i)
+  {
+    passed += feed.put(rmc.data(), rmc.size()) == rmc.size();
+    if (i % 4 == 3)
+      feed.drain(navic);
+  }
+  feed.drain(navic);
+  CHECK(navic.passedChecksum() == passed);
+  CHECK(navic.failedChecksum() == 0);
+  CHECK(feed.dropped() == 50 - passed && feed.dropped() > 0);
+
+  return navic_test_result();
+}
@@ -0,0 +1,168 @@
+/*
+test_satellites - GSV and GSA tables kept per talker
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "navic_rmc_gga++.h"
+#include "navic_dedup.h"
+#include "navic_test.h"
+
+namespace
+{
+// One GSV cycle of count satellites, PRNs from firstPrn, all with SNR snr
+std::string gsv(const char *talker, unsigned count, unsigned firstPrn, unsigned snr, unsigned parts = 0)
+{
+  unsigned total = (count + 3) / 4;
+  if (parts == 0 || parts > total)
+    parts = total;
+  std::string out;
+  for (unsigned part = 1; part <= parts; ++part)
+  {
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%sGSV,%u,%u,%02u", talker, total, part, count);
+    std::string body = buf;
+    for (unsigned i = (part - 1) * 4; i < part * 4 && i < count; ++i)
+    {
+      snprintf(buf, sizeof(buf), ",%02u,%02u,%03u,%02u", firstPrn + i, 10 + i, 20 * i, snr);
+      body += buf;
+    }
+    out += nmea(body);
+  }
+  return out;
+}
+
+unsigned countTalker(navic_gn_rmc_gga &navic, uint8_t talker, unsigned snr)
+{
+  NavIC_satellites_in_view &view = navic.satellitesInView;
+  unsigned found = 0;
+  for (uint8_t i = 0; i < view.count(); ++i)
+    if (view.talker(i) == talker)
+    {
+      CHECK(view.snr(i) == snr);
+      ++found;
+    }
+  return found;
+}
+
+// A GSA using count satellites from firstPrn; system 0 leaves the ID out
+std::string gsa(const char *talker, unsigned count, unsigned firstPrn, unsigned system = 0)
+{
+  char buf[128];
+  snprintf(buf, sizeof(buf), "%sGSA,A,3", talker);
+  std::string body = buf;
+  for (unsigned i = 0; i < 12; ++i)
+  {
+    if (i < count)
+      snprintf(buf, sizeof(buf), ",%02u", firstPrn + i);
+    else
+      snprintf(buf, sizeof(buf), ",");
+    body += buf;
+  }
+  body += ",1.80,1.00,1.50";
+  if (system != 0)
+  {
+    snprintf(buf, sizeof(buf), ",%X", system);
+    body += buf;
+  }
+  return nmea(body);
+}
+
+unsigned countUsed(navic_gn_rmc_gga &navic, uint8_t talker, uint8_t system, unsigned firstPrn)
+{
+  NavIC_active_satellites &used = navic.activeSatellites;
+  unsigned found = 0;
+  for (uint8_t i = 0; i < used.count(); ++i)
+    if (used.talker(i) == talker && used.systemId(i) == system)
+    {
+      CHECK(used.prn(i) >= firstPrn && used.prn(i) < firstPrn + 12);
+      ++found;
+    }
+  return found;
+}
+
+void feed(navic_gn_rmc_gga &navic, const std::string &text)
+{
+  navic.encode(text.data(), text.size());
+}
+}
+
+int main()
+{
+  // GP 12 + GL 12 + GI 8 fill the table exactly; no cycle may push
+  // another talker out
+  navic_gn_rmc_gga navic;
+  for (unsigned cycle = 1; cycle <= 6; ++cycle)
+  {
+    feed(navic, gsv("GP", 12, 1, 30 + cycle));
+    feed(navic, gsv("GL", 12, 65, 30 + cycle));
+    feed(navic, gsv("GI", 8, 1, 30 + cycle));
+    CHECK(navic.satellitesInView.count() == _NavIC_MAX_SATELLITES);
+    CHECK(countTalker(navic, navic_gn_rmc_gga::NAVIC_TALKER_GP, 30 + cycle) == 12);
+    CHECK(countTalker(navic, navic_gn_rmc_gga::NAVIC_TALKER_GL, 30 + cycle) == 12);
+    CHECK(countTalker(navic, navic_gn_rmc_gga::NAVIC_TALKER_GI, 30 + cycle) == 8);
+  }
+
+  // A talker growing past what is free keeps what fits
+  feed(navic, gsv("GI", 12, 1, 40));
+  CHECK(navic.satellitesInView.count() == _NavIC_MAX_SATELLITES);
+  CHECK(countTalker(navic, navic_gn_rmc_gga::NAVIC_TALKER_GP, 36) == 12);
+  CHECK(countTalker(navic, navic_gn_rmc_gga::NAVIC_TALKER_GL, 36) == 12);
+  CHECK(countTalker(navic, navic_gn_rmc_gga::NAVIC_TALKER_GI, 40) == 8);
+
+  // A sequence broken off after overwriting in place drops that talker
+  // only; the others are untouched
+  feed(navic, gsv("GL", 12, 65, 41, 2));
+  feed(navic, gsv("GP", 12, 1, 41));
+  CHECK(countTalker(navic, navic_gn_rmc_gga::NAVIC_TALKER_GL, 41) == 0);
+  CHECK(countTalker(navic, navic_gn_rmc_gga::NAVIC_TALKER_GP, 41) == 12);
+  CHECK(countTalker(navic, navic_gn_rmc_gga::NAVIC_TALKER_GI, 40) == 8);
+  feed(navic, gsv("GL", 12, 65, 42));
+  CHECK(navic.satellitesInView.count() == _NavIC_MAX_SATELLITES);
+  CHECK(countTalker(navic, navic_gn_rmc_gga::NAVIC_TALKER_GL, 42) == 12);
+
+  // With room to spare a sequence stages in the tail, and one broken off
+  // leaves the talker's entries as they were
+  navic_gn_rmc_gga roomy;
+  feed(roomy, gsv("GP", 8, 1, 30));
+  feed(roomy, gsv("GP", 8, 1, 31, 1));
+  feed(roomy, gsv("GL", 4, 65, 31));
+  CHECK(roomy.satellitesInView.count() == 12);
+  CHECK(countTalker(roomy, navic_gn_rmc_gga::NAVIC_TALKER_GP, 30) == 8);
+
+  // One GN GSA per constellation, told apart by system ID: each keeps
+  // its own satellites, and the next epoch replaces them system by system
+  const uint8_t GN = navic_gn_rmc_gga::NAVIC_TALKER_GN;
+  navic_gn_rmc_gga combined;
+  feed(combined, gsa("GN", 8, 1, 1) + gsa("GN", 6, 65, 2) + gsa("GN", 5, 1, 6));
+  CHECK(combined.activeSatellites.count() == 19);
+  CHECK(countUsed(combined, GN, 1, 1) == 8);
+  CHECK(countUsed(combined, GN, 2, 65) == 6);
+  CHECK(countUsed(combined, GN, 6, 1) == 5);
+  feed(combined, gsa("GN", 7, 11, 1) + gsa("GN", 4, 70, 2));
+  CHECK(combined.activeSatellites.count() == 16);
+  CHECK(countUsed(combined, GN, 1, 11) == 7);
+  CHECK(countUsed(combined, GN, 2, 70) == 4);
+  CHECK(countUsed(combined, GN, 6, 1) == 5);
+  CHECK(combined.activeSatellites.systemId() == 2);
+
+  // Talkers without a system ID, and a repeat the cache skips: GL must
+  // not stand in for GP
+  navic_sentence_cache cache;
+  navic_gn_rmc_gga talkers;
+  talkers.dedup(&cache);
+  feed(talkers, gsa("GP", 9, 1) + gsa("GL", 7, 65) + gsa("GP", 9, 1));
+  CHECK(talkers.activeSatellites.count() == 16);
+  CHECK(countUsed(talkers, navic_gn_rmc_gga::NAVIC_TALKER_GP, 0, 1) == 9);
+  CHECK(countUsed(talkers, navic_gn_rmc_gga::NAVIC_TALKER_GL, 0, 65) == 7);
+  CHECK(cache.suppressed() == 1);
+
+  return navic_test_result();
+}
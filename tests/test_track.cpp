@@ -0,0 +1,207 @@
+/*
+test_track - navic_track_filter converges, rejects outliers and agrees
+between its float and 16.16 fixed-point builds
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#include "track_other.h"
+#include "navic_test.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+namespace
+{
+const double originLat = 12.9716, originLng = 77.5946;
+const double metersPerDegree = 6372795.0 * M_PI / 180; // as distanceBetween()
+
+// Tolerances of the checks below
+// over the second minute of a straight track with 4 m of noise per axis
+const double convergedMeters = 4.5;        // RMS filtered position from the truth
+const double convergedCmps = 30;           // mean speed, estimated from positions alone
+const double convergedCentiDegrees = 150;  // mean course
+const double agreeMeters = 0.5;     // float against 16.16 fixed point, fix by fix
+const int32_t agreeCmps = 10;
+
+RawDegrees toRaw(double value)
+{
+  RawDegrees raw;
+  raw.negative = value < 0;
+  value = fabs(value);
+  raw.deg = (uint16_t)value;
+  raw.billionths = (uint32_t)((value - raw.deg) * 1e9 + 0.5);
+  return raw;
+}
+
+// A fix north and east meters from the origin, centiseconds after noon
+NavIC_fix at(double north, double east, uint32_t centiseconds, int32_t hdop = 100)
+{
+  NavIC_fix fix;
+  fix.lat = toRaw(originLat + north / metersPerDegree);
+  fix.lng = toRaw(originLng + east / (metersPerDegree * cos(originLat * M_PI / 180)));
+  uint32_t seconds = centiseconds / 100;
+  fix.time = (12 * 10000 + seconds / 60 * 100 + seconds % 60) * 100 + centiseconds % 100;
+  fix.hdop = hdop;
+  fix.committed = fix.fields = NavIC_fix::LOCATION | NavIC_fix::TIME | NavIC_fix::HDOP;
+  return fix;
+}
+
+// Meters between the filter's estimate and a point given as at() does
+template <class Filter>
+double error(Filter &filter, double north, double east)
+{
+  double dNorth = (filter.latE7() / 1e7 - originLat) * metersPerDegree - north;
+  double dEast = (filter.lngE7() / 1e7 - originLng) * metersPerDegree * cos(originLat * M_PI / 180) - east;
+  return sqrt(dNorth * dNorth + dEast * dEast);
+}
+
+// Gaussian-ish noise of sigma 1, the same on every host
+double noise(uint32_t &state)
+{
+  double sum = 0;
+  for (int i = 0; i < 12; ++i)
+  {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    sum += (state >> 8) / 16777216.0;
+  }
+  return sum - 6;
+}
+
+// 10 m/s on a course of 60 degrees, one fix a second with 4 m of noise
+const double speed = 10, course = 60 * M_PI / 180;
+
+template <class Filter>
+void converge(Filter &filter)
+{
+  uint32_t state = 1;
+  double filtered = 0, measured = 0, cmps = 0, centiDegrees = 0;
+  for (uint32_t t = 0; t < 120; ++t)
+  {
+    double north = speed * cos(course) * t, east = speed * sin(course) * t;
+    double noiseNorth = 4 * noise(state), noiseEast = 4 * noise(state);
+    CHECK(filter.update(at(north + noiseNorth, east + noiseEast, t * 100)));
+    // the second minute, once the velocity has settled
+    if (t >= 60)
+    {
+      double e = error(filter, north, east);
+      filtered += e * e;
+      measured += noiseNorth * noiseNorth + noiseEast * noiseEast;
+      cmps += filter.cmps();
+      centiDegrees += filter.centiDegrees();
+    }
+  }
+  CHECK(sqrt(filtered / 60) < convergedMeters);
+  CHECK(filtered < measured / 2);
+  CHECK(fabs(cmps / 60 - 1000) < convergedCmps);
+  CHECK(fabs(centiDegrees / 60 - 6000) < convergedCentiDegrees);
+  CHECK(filter.accuracyCm() < 300);
+  CHECK(filter.rejected() == 0);
+  // the filtered track is about as long as the true one, 1190 m, not the
+  // noisy one
+  CHECK(filter.centimeters() > 115000 && filter.centimeters() < 125000);
+}
+
+template <class Filter>
+void outliers(Filter &filter)
+{
+  uint32_t t = 0;
+  for (; t < 20; ++t)
+    filter.update(at(0, 0, t * 100));
+
+  // one multipath jump is rejected and leaves the estimate alone
+  uint32_t rejected = filter.rejected();
+  CHECK(!filter.update(at(300, 0, t++ * 100)));
+  CHECK(filter.rejected() == rejected + 1);
+  CHECK(error(filter, 0, 0) < 1);
+  CHECK(filter.update(at(0, 0, t++ * 100)));
+
+  // the receiver really moved: after _NavIC_TRACK_MAX_REJECTS outliers the
+  // filter starts again at the next fix
+  for (int i = 0; i < _NavIC_TRACK_MAX_REJECTS; ++i)
+    CHECK(!filter.update(at(1500, 0, t++ * 100)));
+  CHECK(filter.update(at(1500, 0, t++ * 100)));
+  CHECK(error(filter, 1500, 0) < 0.05);
+
+  // reset() starts again just the same
+  filter.reset();
+  CHECK(filter.update(at(-700, 400, t++ * 100)));
+  CHECK(error(filter, -700, 400) < 0.05);
+}
+
+template <class Filter>
+void saturation(Filter &filter)
+{
+  // a 10 s gap, the longest predicted over, at 60 m/s
+  NavIC_fix fix = at(0, 0, 0);
+  fix.speed = (int32_t)(60 / _NavIC_MPS_PER_KNOT * 100);
+  fix.course = 0;
+  fix.committed = fix.fields |= NavIC_fix::SPEED | NavIC_fix::COURSE;
+  CHECK(filter.update(fix));
+  fix = at(600, 0, 1000);
+  fix.speed = (int32_t)(60 / _NavIC_MPS_PER_KNOT * 100);
+  fix.committed = fix.fields |= NavIC_fix::SPEED | NavIC_fix::COURSE;
+  CHECK(filter.update(fix));
+  CHECK(error(filter, 600, 0) < 5);
+  CHECK(abs(filter.cmps() - 6000) < 100);
+
+  // innovations far past what 16.16 holds are rejected, never wrapped
+  // into a fix somewhere else; the estimate coasts on at 60 m/s
+  uint32_t accepted = filter.accepted();
+  CHECK(!filter.update(at(100000, 0, 1100)));
+  CHECK(!filter.update(at(0, -5000000, 1200)));
+  CHECK(!filter.update(at(-2000000, 3000000, 1300, 1900)));
+  CHECK(filter.accepted() == accepted);
+  CHECK(error(filter, 780, 0) < 5);
+
+  // and a gap past _NavIC_TRACK_MAX_GAP starts again wherever it lands
+  CHECK(filter.update(at(100000, 0, 1300 + _NavIC_TRACK_MAX_GAP + 1)));
+  CHECK(error(filter, 100000, 0) < 0.05);
+}
+}
+
+int main()
+{
+  navic_track_filter library;
+  navic_track_other other;
+  converge(library);
+  converge(other);
+
+  navic_track_filter rejectLibrary;
+  navic_track_other rejectOther;
+  outliers(rejectLibrary);
+  outliers(rejectOther);
+
+  navic_track_filter saturateLibrary;
+  navic_track_other saturateOther;
+  saturation(saturateLibrary);
+  saturation(saturateOther);
+
+  // Both builds, fed the same noisy track, stay within agreeMeters
+  navic_track_filter a;
+  navic_track_other b;
+  uint32_t state = 7;
+  for (uint32_t t = 0; t < 300; ++t)
+  {
+    double turn = t < 150 ? course : course + (t - 150) * 0.02;
+    double north = speed * cos(turn) * t, east = speed * sin(turn) * t;
+    NavIC_fix fix = at(north + 4 * noise(state), east + 4 * noise(state), t * 100, 80 + t % 50);
+    CHECK(a.update(fix) == b.update(fix));
+    double dNorth = (a.latE7() - b.latE7()) / 1e7 * metersPerDegree;
+    double dEast = (a.lngE7() - b.lngE7()) / 1e7 * metersPerDegree * cos(originLat * M_PI / 180);
+    CHECK(sqrt(dNorth * dNorth + dEast * dEast) < agreeMeters);
+    CHECK(abs(a.cmps() - b.cmps()) < agreeCmps);
+  }
+  CHECK(a.accepted() == b.accepted());
+
+  return navic_test_result();
+}
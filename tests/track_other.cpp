@@ -0,0 +1,16 @@
+/*
+track_other - navic_track_filter in the arithmetic the library was not
+built with, as navic_track_other
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+
+#define _NavIC_TRACK_OTHER_SOURCE
+#include "track_other.h"
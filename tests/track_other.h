@@ -0,0 +1,44 @@
+/*
+track_other - navic_track_filter in the arithmetic the library was not
+built with, as navic_track_other, so one test can run both side by side
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+*/
+#ifndef __track_other_h
+#define __track_other_h
+
+#if defined(_NavIC_TRACK_FIXED) && _NavIC_TRACK_FIXED
+#define _NavIC_TRACK_OTHER 0
+#else
+#define _NavIC_TRACK_OTHER 1
+#endif
+
+#ifndef _NavIC_TRACK_OTHER_SOURCE
+#include "navic_track.h"
+#undef __navic_track_h
+#endif
+
+// navic_track.h, or with _NavIC_TRACK_OTHER_SOURCE navic_track.cpp, once
+// more under other names
+#undef _NavIC_TRACK_FIXED
+#define _NavIC_TRACK_FIXED _NavIC_TRACK_OTHER
+#define navic_track_filter navic_track_other
+#define navic_track_real navic_track_other_real
+#ifdef _NavIC_TRACK_OTHER_SOURCE
+#include "navic_track.cpp"
+#else
+#include "navic_track.h"
+#endif
+#undef navic_track_filter
+#undef navic_track_real
+#undef _NavIC_TRACK_FIXED
+#define _NavIC_TRACK_FIXED !_NavIC_TRACK_OTHER
+
+#endif // def(__track_other_h)
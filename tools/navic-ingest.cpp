@@ -0,0 +1,340 @@
+/*
+navic-ingest - serve NMEA over TCP/UDP, or load-test the server over loopback
+
+usage: navic-ingest [-a address] [-t tcp-port] [-u udp-port] [-j threads]
+                    [-m max-sources] [-i idle-ms] [-q]
+       navic-ingest -l tcp-receivers [-U udp-receivers] [-e epochs] [-j threads]
+
+The first form prints one CSV line per committed fix until interrupted;
+-q prints a summary each second on stderr instead.  The second starts the
+server on loopback, streams a generated corpus (bench/navic_corpus.h) to it
+from stand-in receivers, TCP in pieces of random size and UDP a datagram
+per epoch, and checks that every sentence arrived and decoded.
+*/
+
+#include "navic_ingest.h"
+#include "navic_corpus.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+static const char *talkers[] = {"GP", "GL", "GA", "GB", "GI", "GQ", "GN", "??"};
+static const size_t CORPORA = 16; // distinct texts the stand-in receivers cycle through
+
+static std::mutex printLock;
+static std::atomic<uint64_t> fixCount(0);
+static volatile sig_atomic_t interrupted = 0;
+
+static void onInterrupt(int)
+{
+  interrupted = 1;
+}
+
+static void printDegrees(const RawDegrees &deg)
+{
+  printf("%s%u.%09u", deg.negative ? "-" : "", deg.deg, deg.billionths);
+}
+
+static void printFix(const NavIC_ingest_source &source, const NavIC_fix &fix, void *)
+{
+  std::lock_guard<std::mutex> guard(printLock);
+  printf("%llu,%s,%s,%06u,%08u,", (unsigned long long)source.id, talkers[fix.talker],
+         fix.sentence == navic_gn_rmc_gga::NAVIC_SENTENCE_RMC ? "RMC" : "GGA", fix.date, fix.time);
+  printDegrees(fix.lat);
+  putchar(',');
+  printDegrees(fix.lng);
+  printf(",%d,%d,%d,%u,%d\n", fix.speed, fix.course, fix.altitude, fix.satellites, fix.hdop);
+}
+
+static void countFix(const NavIC_ingest_source &, const NavIC_fix &, void *)
+{
+  fixCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+static double now()
+{
+  timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void printStats(const NavIC_ingest_stats &s)
+{
+  fprintf(stderr, "%llu sources (%llu refused, %llu closed), %llu bytes, %llu datagrams, %llu passed, %llu failed, %llu fixes\n",
+          (unsigned long long)s.accepted, (unsigned long long)s.refused, (unsigned long long)s.closed,
+          (unsigned long long)s.bytes, (unsigned long long)s.datagrams, (unsigned long long)s.passedChecksum,
+          (unsigned long long)s.failedChecksum, (unsigned long long)fixCount.load());
+}
+
+static int serve(const NavIC_ingest_config &config, bool quiet)
+{
+  navic_ingest_server server;
+  if (!server.start(config, quiet ? countFix : printFix))
+  {
+    perror("navic-ingest");
+    return 1;
+  }
+  fprintf(stderr, "listening on %s, tcp %d, udp %d\n", config.address, server.tcpPort(), server.udpPort());
+
+  signal(SIGINT, onInterrupt);
+  signal(SIGTERM, onInterrupt);
+  while (!interrupted)
+  {
+    sleep(1);
+    if (quiet)
+    {
+      NavIC_ingest_stats s;
+      server.stats(s);
+      printStats(s);
+    }
+  }
+  server.stop();
+  return 0;
+}
+
+// What a parser makes of one text: the totals the server must reach
+struct Expected
+{
+  uint64_t passed, failed, fixes;
+};
+
+static void countExpected(const NavIC_fix &, void *context)
+{
+  ++((Expected *)context)->fixes;
+}
+
+static Expected expect(const std::string &text)
+{
+  Expected e = {0, 0, 0};
+  navic_gn_rmc_gga navic;
+  NavIC_LISTENER listener(navic, countExpected, &e);
+  navic.encode(text.data(), text.size());
+  e.passed = navic.passedChecksum();
+  e.failed = navic.failedChecksum();
+  return e;
+}
+
+// Whole epochs of text, each small enough for one datagram
+static std::vector<std::string> datagrams(const std::string &text)
+{
+  std::vector<std::string> out;
+  size_t start = 0;
+  for (size_t next = text.find("$GNRMC", 1); start < text.size(); next = text.find("$GNRMC", next + 1))
+  {
+    if (next == std::string::npos)
+      next = text.size();
+    out.push_back(text.substr(start, next - start));
+    start = next;
+  }
+  return out;
+}
+
+static int loopback(unsigned tcpReceivers, unsigned udpReceivers, size_t epochs, unsigned threads)
+{
+  // both ends of every connection are in this process
+  rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+  {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+
+  std::vector<std::string> texts;
+  std::vector<std::vector<std::string> > epochTexts;
+  std::vector<Expected> expected;
+  for (size_t i = 0; i < CORPORA; ++i)
+  {
+    texts.push_back(navic_corpus(i + 1).generate(epochs));
+    epochTexts.push_back(datagrams(texts.back()));
+    expected.push_back(expect(texts.back()));
+  }
+
+  NavIC_ingest_config config;
+  config.address = "127.0.0.1";
+  config.tcpPort = 0;
+  config.udpPort = 0;
+  config.threads = threads;
+  config.idleMs = 0;
+  navic_ingest_server server;
+  if (!server.start(config, countFix))
+  {
+    perror("navic-ingest");
+    return 1;
+  }
+  sockaddr_in tcpAddr, udpAddr;
+  memset(&tcpAddr, 0, sizeof(tcpAddr));
+  tcpAddr.sin_family = AF_INET;
+  tcpAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  udpAddr = tcpAddr;
+  tcpAddr.sin_port = htons(server.tcpPort());
+  udpAddr.sin_port = htons(server.udpPort());
+
+  Expected total = {0, 0, 0};
+  uint64_t bytes = 0, sentDatagrams = 0;
+  std::vector<int> tcp(tcpReceivers), udp(udpReceivers);
+  for (unsigned i = 0; i < tcpReceivers + udpReceivers; ++i)
+  {
+    const Expected &e = expected[i % CORPORA];
+    total.passed += e.passed;
+    total.failed += e.failed;
+    total.fixes += e.fixes;
+    bytes += texts[i % CORPORA].size();
+  }
+  for (unsigned i = 0; i < tcpReceivers; ++i)
+  {
+    tcp[i] = socket(AF_INET, SOCK_STREAM, 0);
+    if (tcp[i] < 0 || connect(tcp[i], (sockaddr *)&tcpAddr, sizeof(tcpAddr)) != 0)
+    {
+      perror("connect");
+      return 1;
+    }
+  }
+  for (unsigned i = 0; i < udpReceivers; ++i)
+  {
+    udp[i] = socket(AF_INET, SOCK_DGRAM, 0);
+    if (udp[i] < 0 || connect(udp[i], (sockaddr *)&udpAddr, sizeof(udpAddr)) != 0)
+    {
+      perror("connect");
+      return 1;
+    }
+  }
+
+  // Round robin over the receivers, a piece of each text at a time, as
+  // interleaved as a fleet's traffic would be
+  double start = now();
+  navic_corpus_random random(1);
+  std::vector<size_t> offset(tcpReceivers + udpReceivers, 0);
+  for (size_t round = 0, active = offset.size(); active != 0; ++round)
+  {
+    active = 0;
+    for (unsigned i = 0; i < tcpReceivers; ++i)
+    {
+      const std::string &text = texts[i % CORPORA];
+      if (offset[i] >= text.size())
+        continue;
+      size_t len = 1 + random.below(1500);
+      if (len > text.size() - offset[i])
+        len = text.size() - offset[i];
+      ssize_t n = send(tcp[i], text.data() + offset[i], len, MSG_NOSIGNAL);
+      if (n < 0)
+      {
+        perror("send");
+        return 1;
+      }
+      offset[i] += n;
+      active += offset[i] < text.size();
+    }
+    for (unsigned i = 0; i < udpReceivers; ++i)
+    {
+      const std::vector<std::string> &epochs = epochTexts[(tcpReceivers + i) % CORPORA];
+      if (round >= epochs.size())
+        continue;
+      if (send(udp[i], epochs[round].data(), epochs[round].size(), 0) > 0)
+        ++sentDatagrams;
+      active += round + 1 < epochs.size();
+    }
+    // UDP has no flow control: hold back while the server is far behind
+    for (NavIC_ingest_stats s; udpReceivers && (server.stats(s), sentDatagrams - s.datagrams > 1024);)
+      usleep(1000);
+  }
+  for (unsigned i = 0; i < tcpReceivers; ++i)
+    close(tcp[i]);
+
+  // wait for the server to catch up, or to stop making progress
+  NavIC_ingest_stats s;
+  uint64_t last = ~(uint64_t)0;
+  for (;;)
+  {
+    server.stats(s);
+    if ((s.bytes == bytes && s.closed == tcpReceivers) || s.bytes == last)
+      break;
+    last = s.bytes;
+    usleep(200000);
+  }
+  double elapsed = now() - start;
+  for (unsigned i = 0; i < udpReceivers; ++i)
+    close(udp[i]);
+  server.stop();
+
+  printStats(s);
+  fprintf(stderr, "%.2f s, %.1f MB/s, %.0f sentences/s\n", elapsed, s.bytes / elapsed / 1e6,
+          (s.passedChecksum + s.failedChecksum) / elapsed);
+  if (s.datagrams != sentDatagrams)
+    fprintf(stderr, "%llu of %llu datagrams lost in the socket buffer\n",
+            (unsigned long long)(sentDatagrams - s.datagrams), (unsigned long long)sentDatagrams);
+  else if (s.bytes != bytes || s.passedChecksum != total.passed || s.failedChecksum != total.failed ||
+           fixCount.load() != total.fixes)
+  {
+    fprintf(stderr, "expected %llu bytes, %llu passed, %llu failed, %llu fixes\n", (unsigned long long)bytes,
+            (unsigned long long)total.passed, (unsigned long long)total.failed, (unsigned long long)total.fixes);
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  NavIC_ingest_config config;
+  unsigned tcpReceivers = 0, udpReceivers = 0;
+  size_t epochs = 60;
+  bool quiet = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "a:t:u:j:m:i:ql:U:e:")) != -1)
+  {
+    switch (opt)
+    {
+    case 'a':
+      config.address = optarg;
+      break;
+    case 't':
+      config.tcpPort = atoi(optarg);
+      break;
+    case 'u':
+      config.udpPort = atoi(optarg);
+      break;
+    case 'j':
+      config.threads = atoi(optarg);
+      break;
+    case 'm':
+      config.maxSources = strtoul(optarg, NULL, 10);
+      break;
+    case 'i':
+      config.idleMs = strtoul(optarg, NULL, 10);
+      break;
+    case 'q':
+      quiet = true;
+      break;
+    case 'l':
+      tcpReceivers = atoi(optarg);
+      break;
+    case 'U':
+      udpReceivers = atoi(optarg);
+      break;
+    case 'e':
+      epochs = strtoul(optarg, NULL, 10);
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-a address] [-t tcp-port] [-u udp-port] [-j threads] [-m max-sources] [-i idle-ms] [-q]\n"
+                      "       %s -l tcp-receivers [-U udp-receivers] [-e epochs] [-j threads]\n",
+              argv[0], argv[0]);
+      return 2;
+    }
+  }
+
+  if (tcpReceivers || udpReceivers)
+    return loopback(tcpReceivers, udpReceivers, epochs, config.threads);
+  if (config.tcpPort < 0 && config.udpPort < 0)
+    config.tcpPort = config.udpPort = 10110; // the port gpsd and most NMEA-over-IP sources use
+  return serve(config, quiet);
+}
@@ -0,0 +1,82 @@
+/*
+navic-replay - re-derive RMC/GGA fixes from a recorded NMEA capture
+
+usage: navic-replay [-j threads] [-q] capture.nmea
+
+Prints one CSV line per committed fix in file order, followed by a summary
+on stderr.  -q prints the summary only.
+*/
+
+#include "navic_mmap.h"
+#include "navic_replay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char *talkers[] = {"GP", "GL", "GA", "GB", "GI", "GQ", "GN", "??"};
+
+static void printDegrees(const RawDegrees &deg)
+{
+  printf("%s%u.%09u", deg.negative ? "-" : "", deg.deg, deg.billionths);
+}
+
+int main(int argc, char **argv)
+{
+  unsigned threads = 0;
+  bool quiet = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "j:q")) != -1)
+  {
+    switch (opt)
+    {
+    case 'j':
+      threads = atoi(optarg);
+      break;
+    case 'q':
+      quiet = true;
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-j threads] [-q] capture.nmea\n", argv[0]);
+      return 2;
+    }
+  }
+  if (optind != argc - 1)
+  {
+    fprintf(stderr, "usage: %s [-j threads] [-q] capture.nmea\n", argv[0]);
+    return 2;
+  }
+
+  // the chunks are decoded in parallel, so map the capture in one piece
+  navic_mapped_file capture;
+  if (!capture.open(argv[optind], 0))
+  {
+    perror(argv[optind]);
+    return 1;
+  }
+  const char *data = "";
+  size_t len = 0;
+  capture.next(data, len);
+
+  NavIC_replay_result result;
+  navic_replay(data, len, result, threads);
+
+  if (!quiet)
+  {
+    printf("talker,sentence,date,time,lat,lng,speed,course,altitude,satellites,hdop\n");
+    for (size_t i = 0; i < result.fixes.size(); ++i)
+    {
+      const NavIC_fix &fix = result.fixes[i];
+      printf("%s,%s,%06u,%08u,", talkers[fix.talker], fix.sentence == navic_gn_rmc_gga::NAVIC_SENTENCE_RMC ? "RMC" : "GGA", fix.date, fix.time);
+      printDegrees(fix.lat);
+      putchar(',');
+      printDegrees(fix.lng);
+      printf(",%d,%d,%d,%u,%d\n", fix.speed, fix.course, fix.altitude, fix.satellites, fix.hdop);
+    }
+  }
+
+  fprintf(stderr, "%llu chars, %llu passed, %llu failed, %zu fixes\n", (unsigned long long)result.charsProcessed,
+          (unsigned long long)result.passedChecksum, (unsigned long long)result.failedChecksum, result.fixes.size());
+  return 0;
+}